@@ -6,16 +6,17 @@
 
 // Function prototypes
 void login();
-void mainMenu(char names[][30], int quantity[], float price[], int *count);
-void addItem(char names[][30], int quantity[], float price[], int *count);
-void removeItem(char names[][30], int quantity[], float price[], int *count);
-void updateItem(char names[][30], int quantity[], float price[], int count);
-void displayInventory(char names[][30], int quantity[], float price[], int count);
+void mainMenu(char names[][30], int quantity[], long long price[], int *count);
+void addItem(char names[][30], int quantity[], long long price[], int *count);
+void removeItem(char names[][30], int quantity[], long long price[], int *count);
+void updateItem(char names[][30], int quantity[], long long price[], int count);
+void displayInventory(char names[][30], int quantity[], long long price[], int count);
+int readPrice(long long *price);
 
 int main() {
     char names[MAX_PRODUCTS][30];
     int quantity[MAX_PRODUCTS];
-    float price[MAX_PRODUCTS];
+    long long price[MAX_PRODUCTS]; // Prices in cents, so they are stored exactly
     int count = 0;
 
     login(); // Login before accessing the main menu
@@ -33,7 +34,7 @@ void login() {
     printf("Login successful!\n");
 }
 
-void mainMenu(char names[][30], int quantity[], float price[], int *count) {
+void mainMenu(char names[][30], int quantity[], long long price[], int *count) {
     int option;
 
     do {
@@ -68,14 +69,14 @@ void mainMenu(char names[][30], int quantity[], float price[], int *count) {
     } while (option != 5);
 }
 
-void addItem(char names[][30], int quantity[], float price[], int *count) {
+void addItem(char names[][30], int quantity[], long long price[], int *count) {
     if (*count < MAX_PRODUCTS) {
         printf("Enter product name: ");
         scanf("%s", names[*count]);
         printf("Enter quantity: ");
         scanf("%d", &quantity[*count]);
         printf("Enter price: ");
-        scanf("%f", &price[*count]);
+        if (!readPrice(&price[*count])) return;
         (*count)++;
         printf("Item added successfully!\n");
     } else {
@@ -83,7 +84,7 @@ void addItem(char names[][30], int quantity[], float price[], int *count) {
     }
 }
 
-void removeItem(char names[][30], int quantity[], float price[], int *count) {
+void removeItem(char names[][30], int quantity[], long long price[], int *count) {
     if (*count == 0) {
         printf("No items to remove.\n");
         return;
@@ -114,7 +115,7 @@ void removeItem(char names[][30], int quantity[], float price[], int *count) {
     }
 }
 
-void updateItem(char names[][30], int quantity[], float price[], int count) {
+void updateItem(char names[][30], int quantity[], long long price[], int count) {
     if (count == 0) {
         printf("No items to update.\n");
         return;
@@ -136,14 +137,14 @@ void updateItem(char names[][30], int quantity[], float price[], int count) {
         printf("Enter new quantity: ");
         scanf("%d", &quantity[found]);
         printf("Enter new price: ");
-        scanf("%f", &price[found]);
+        if (!readPrice(&price[found])) return;
         printf("Item updated successfully!\n");
     } else {
         printf("Item not found.\n");
     }
 }
 
-void displayInventory(char names[][30], int quantity[], float price[], int count) {
+void displayInventory(char names[][30], int quantity[], long long price[], int count) {
     if (count == 0) {
         printf("No items in inventory.\n");
         return;
@@ -153,7 +154,38 @@ void displayInventory(char names[][30], int quantity[], float price[], int count
     printf("----------------------------------------------------\n");
     printf("No.\tName\t\tQuantity\tPrice\n");
     for (int i = 0; i < count; i++) {
-        printf("%d\t%s\t\t%d\t\t%.2f\n", i+1, names[i], quantity[i], price[i]);
+        printf("%d\t%s\t\t%d\t\t%lld.%02lld\n", i+1, names[i], quantity[i], price[i] / 100, price[i] % 100);
     }
     printf("----------------------------------------------------\n\n");
 }
+
+// Reads a price such as 12.34 into *price in cents, asking again until the input is a
+// non-negative amount with at most two decimals. Returns 0 if the input ends first.
+int readPrice(long long *price) {
+    char text[32];
+
+    while (scanf("%31s", text) == 1) {
+        char *p = text;
+        long long whole = 0, cents = 0;
+        int digits = 0, decimals = 0;
+
+        while (*p >= '0' && *p <= '9' && digits < 15) {
+            whole = whole * 10 + (*p++ - '0');
+            digits++;
+        }
+        if (*p == '.') {
+            p++;
+            while (*p >= '0' && *p <= '9' && decimals < 2) {
+                cents = cents * 10 + (*p++ - '0');
+                decimals++;
+            }
+        }
+        if (*p == '\0' && digits + decimals > 0) {
+            if (decimals == 1) cents *= 10;
+            *price = whole * 100 + cents;
+            return 1;
+        }
+        printf("Invalid price! Enter an amount such as 12.34: ");
+    }
+    return 0;
+}
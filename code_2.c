@@ -8,7 +8,7 @@
 typedef struct product {
     char *name;             // Name of the product (string)
     int quantity;           // Quantity of the product (integer)
-    float price;            // Price of the product (float)
+    long long price;        // Price of the product in cents (exact, unlike float)
     struct product *new_address; // Pointer to the next product (linked list)
 } product;
 
@@ -33,6 +33,7 @@ void updateItem(product *head, int *count);
 void displayInventory(product *head, int count);
 void displayTransactions(Stack *transactionStack);
 int getIntInput(const char *prompt);
+long long getPriceInput(const char *prompt);
 char *getStringInput(const char *prompt);
 void pushTransaction(Stack *stack, const char *name, const char *type);
 
@@ -129,6 +130,39 @@ int getIntInput(const char *prompt) {
     }
 }
 
+// Function to get a price such as 12.34 from the user, returned in cents
+long long getPriceInput(const char *prompt) {
+    char buffer[100];  // Temporary buffer to store input
+
+    while (1) {
+        printf("%s", prompt);
+        if (fgets(buffer, sizeof(buffer), stdin) != NULL) {
+            long long whole = 0, cents = 0;
+            int decimals = 0, digits = 0;
+            char *p = buffer;
+            // Parse the whole part and at most two decimals
+            while (*p >= '0' && *p <= '9' && digits < 15) {
+                whole = whole * 10 + (*p++ - '0');
+                digits++;
+            }
+            if (*p == '.') {
+                p++;
+                while (*p >= '0' && *p <= '9' && decimals < 2) {
+                    cents = cents * 10 + (*p++ - '0');
+                    decimals++;
+                }
+            }
+            if ((digits > 0 || decimals > 0) && (*p == '\n' || *p == '\0')) {
+                if (decimals == 1) cents *= 10;
+                return whole * 100 + cents; // Return valid price in cents
+            }
+            printf("Invalid input! Please enter a price like 12.34.\n");
+        } else {
+            printf("Error reading input. Please try again.\n");
+        }
+    }
+}
+
 // Function to get string input dynamically (handles any size of input)
 char *getStringInput(const char *prompt) {
     char *input = NULL;
@@ -167,9 +201,7 @@ void addItem(product **head, product **current, Stack *transactionStack, int *co
     // Get the product details from the user
     newProduct->name = getStringInput("Enter product name: ");
     newProduct->quantity = getIntInput("Enter quantity: ");
-    printf("Enter price: ");
-    scanf("%f", &newProduct->price); // Read price input
-    while (getchar() != '\n');  // Clear input buffer
+    newProduct->price = getPriceInput("Enter price: "); // Read price input in cents
 
     newProduct->new_address = NULL; // Initialize new_address pointer to NULL
     if (*head == NULL) {
@@ -256,9 +288,7 @@ void updateItem(product *head, int *count) {
         if (strcmp(temp->name, nameToUpdate) == 0) {
             // Get updated product details from the user
             temp->quantity = getIntInput("Enter new quantity: ");
-            printf("Enter new price: ");
-            scanf("%f", &temp->price);
-            while (getchar() != '\n'); // Clear input buffer
+            temp->price = getPriceInput("Enter new price: ");
             printf("Item updated successfully!\n");
             free(nameToUpdate); // Free name input
             return;
@@ -281,7 +311,7 @@ void displayInventory(product *head, int count) {
     product *temp = head;
     int i = 1; // Product number
     while (temp != NULL) {
-        printf("%d\t%s\t\t%d\t\t%.2f\n", i++, temp->name, temp->quantity, temp->price);
+        printf("%d\t%s\t\t%d\t\t%lld.%02lld\n", i++, temp->name, temp->quantity, temp->price / 100, temp->price % 100);
         temp = temp->new_address; // Move to the next product
     }
 }
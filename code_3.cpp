@@ -1,17 +1,18 @@
 #include <iostream>
 #include <string>
 #include <limits>
+#include <cctype>
 
 // Class to represent a product
 class Product {
 public:
     std::string name;  // Product name
     int quantity;      // Product quantity
-    float price;       // Product price
+    long long price;   // Product price in cents (exact, unlike float)
     Product* next;     // Pointer to the next product
 
     // Constructor to initialize a product
-    Product(std::string name, int quantity, float price)
+    Product(std::string name, int quantity, long long price)
         : name(name), quantity(quantity), price(price), next(nullptr) {}
 };
 
@@ -53,9 +54,10 @@ public:
         Transaction* current = top;
         int i = 1;
         while (current) {
-            std::cout << i++ << "\t" << current->name << "\t\t" << current->type << std::endl;
+            std::cout << i++ << "\t" << current->name << "\t\t" << current->type << "\n"; // No flush per row
             current = current->next;
         }
+        std::cout.flush();
     }
 
     // Destructor to clean up transaction memory
@@ -86,18 +88,49 @@ public:
         }
     }
 
+    // Function to read a price such as 12.34 into cents, asking again until the input is a
+    // non-negative amount with at most two decimals; returns false if the input ends first
+    static bool readPrice(long long& price) {
+        std::string text;
+        while (std::cin >> text) {
+            long long whole = 0, cents = 0;
+            int digits = 0, decimals = 0;
+            std::size_t i = 0;
+            for (; i < text.size() && std::isdigit(static_cast<unsigned char>(text[i])) && digits < 15; ++i, ++digits)
+                whole = whole * 10 + (text[i] - '0');
+            if (i < text.size() && text[i] == '.') {
+                for (++i; i < text.size() && std::isdigit(static_cast<unsigned char>(text[i])) && decimals < 2; ++i, ++decimals)
+                    cents = cents * 10 + (text[i] - '0');
+            }
+            if (i == text.size() && digits + decimals > 0) {
+                if (decimals == 1) cents *= 10;
+                price = whole * 100 + cents;
+                return true;
+            }
+            std::cout << "Invalid price. Enter an amount such as 12.34: ";
+        }
+        return false;
+    }
+
+    // Function to format a price in cents as 12.34 (or -0.05 for a negative amount)
+    static std::string formatPrice(long long cents) {
+        unsigned long long magnitude = cents < 0 ? 0 - static_cast<unsigned long long>(cents) : static_cast<unsigned long long>(cents);
+        std::string fraction = std::to_string(magnitude % 100);
+        return (cents < 0 ? "-" : "") + std::to_string(magnitude / 100) + "." + (fraction.size() < 2 ? "0" : "") + fraction;
+    }
+
     // Function to add a new item to the inventory
     void addItem() {
         std::string name;
         int quantity;
-        float price;
+        long long price;
 
         std::cout << "Enter product name: ";
         std::getline(std::cin, name);
         std::cout << "Enter quantity: ";
         std::cin >> quantity;
         std::cout << "Enter price: ";
-        std::cin >> price;
+        if (!readPrice(price)) return;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
 
         Product* newProduct = new Product(name, quantity, price);
@@ -177,7 +210,7 @@ public:
                 std::cout << "Enter new quantity: ";
                 std::cin >> temp->quantity;
                 std::cout << "Enter new price: ";
-                std::cin >> temp->price;
+                if (!readPrice(temp->price)) return;
                 std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
                 std::cout << "Item updated successfully!\n";
                 return;
@@ -199,9 +232,10 @@ public:
         Product* temp = head;
         int i = 1;
         while (temp) {
-            std::cout << i++ << "\t" << temp->name << "\t\t" << temp->quantity << "\t\t" << temp->price << std::endl;
+            std::cout << i++ << "\t" << temp->name << "\t\t" << temp->quantity << "\t\t" << formatPrice(temp->price) << "\n"; // No flush per row
             temp = temp->next;
         }
+        std::cout.flush();
     }
 };
 
@@ -5,300 +5,6988 @@
 #include <queue>
 #include <exception>
 #include <vector>
+#include <tuple>
+#include <utility>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <cctype>
+#include <sstream>
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <functional>
+#include <future>
+#include <deque>
+#include <filesystem>
+#include <optional>
+#include <system_error>
+#include <coroutine>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define IMS_HAVE_AVX2 1 // AVX2 kernels are compiled in and chosen at run time
+#endif
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define IMS_HAVE_IO_URING 1
+#endif
 
-// Base class for inventory items
+// Exact amount of money stored as a whole number of cents. Sums and products of Money never
+// drift the way float prices did.
+class Money {
+    std::int64_t cents = 0;
+
+    constexpr explicit Money(std::int64_t c) : cents(c) {}
+
+public:
+    constexpr Money() = default;
+
+    // Function to create an amount from cents
+    static constexpr Money fromCents(std::int64_t c) { return Money(c); }
+
+    // Function to parse "12", "12.5", "12.34" or "-3.10"; throws std::invalid_argument otherwise
+    static Money parse(const std::string& text) {
+        std::size_t at = 0;
+        bool negative = !text.empty() && text[0] == '-';
+        if (negative) ++at;
+        std::int64_t whole = 0, fraction = 0;
+        std::size_t digits = 0, decimals = 0;
+        for (; at < text.size() && std::isdigit(static_cast<unsigned char>(text[at])); ++at, ++digits) {
+            if (digits == 15) throw std::invalid_argument("Amount too large: " + text);
+            whole = whole * 10 + (text[at] - '0');
+        }
+        if (at < text.size() && text[at] == '.') {
+            for (++at; at < text.size() && std::isdigit(static_cast<unsigned char>(text[at])); ++at, ++decimals) {
+                if (decimals == 2) throw std::invalid_argument("Amount has more than two decimals: " + text);
+                fraction = fraction * 10 + (text[at] - '0');
+            }
+        }
+        if (at != text.size() || digits + decimals == 0) throw std::invalid_argument("Invalid amount: " + text);
+        if (decimals == 1) fraction *= 10;
+        std::int64_t total = whole * 100 + fraction;
+        return Money(negative ? -total : total);
+    }
+
+    constexpr std::int64_t toCents() const { return cents; }
+
+    // Function to format the amount with two decimals, e.g. "12.30"
+    std::string toString() const {
+        std::uint64_t magnitude = cents < 0 ? 0 - static_cast<std::uint64_t>(cents) : static_cast<std::uint64_t>(cents);
+        char text[32];
+        std::snprintf(text, sizeof(text), "%s%llu.%02llu", cents < 0 ? "-" : "",
+                      static_cast<unsigned long long>(magnitude / 100), static_cast<unsigned long long>(magnitude % 100));
+        return text;
+    }
+
+    // Function to append the amount with two decimals to text without a temporary string, for
+    // formatting many records into one buffer
+    void appendTo(std::string& text) const {
+        std::uint64_t magnitude = cents < 0 ? 0 - static_cast<std::uint64_t>(cents) : static_cast<std::uint64_t>(cents);
+        char digits[24];
+        char* end = std::to_chars(digits, digits + sizeof(digits), magnitude / 100).ptr;
+        if (cents < 0) text += '-';
+        text.append(digits, end);
+        text += '.';
+        text += static_cast<char>('0' + magnitude % 100 / 10);
+        text += static_cast<char>('0' + magnitude % 10);
+    }
+
+    Money operator+(Money other) const { return Money(cents + other.cents); }
+    Money operator-(Money other) const { return Money(cents - other.cents); }
+    Money operator*(std::int64_t times) const { return Money(cents * times); }
+    Money& operator+=(Money other) {
+        cents += other.cents;
+        return *this;
+    }
+
+    bool operator==(Money other) const { return cents == other.cents; }
+    bool operator!=(Money other) const { return cents != other.cents; }
+    bool operator<(Money other) const { return cents < other.cents; }
+    bool operator>(Money other) const { return cents > other.cents; }
+    bool operator<=(Money other) const { return cents <= other.cents; }
+    bool operator>=(Money other) const { return cents >= other.cents; }
+
+    friend std::ostream& operator<<(std::ostream& out, Money amount) { return out << amount.toString(); }
+};
+
+// Column kernels over Money amounts stored as contiguous cents. Each kernel has an AVX2 path and
+// a scalar path with identical results. On x86-64 the AVX2 path is compiled in even without
+// -mavx2 and is used whenever the CPU supports it, so the default build gets it too.
+
+// Function to tell whether the AVX2 kernels can run on this CPU
+inline bool useAvx2() {
+#if defined(__AVX2__)
+    return true;
+#elif defined(IMS_HAVE_AVX2)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+#ifdef IMS_HAVE_AVX2
+// Helper function: AVX2 part of columnValue over the first n - n % 4 amounts
+__attribute__((target("avx2"))) inline std::int64_t columnValueAvx2(const std::int32_t* quantity,
+                                                                   const std::int64_t* cents, std::size_t n) {
+    // 64-bit lane multiply from 32x32 partial products (AVX2 has no 64-bit mullo)
+    __m256i sum = _mm256_setzero_si256();
+    for (std::size_t i = 0; i + 4 <= n; i += 4) {
+        __m256i q = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(quantity + i)));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cents + i));
+        __m256i low = _mm256_mul_epu32(q, c);
+        __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(q, _mm256_srli_epi64(c, 32)),
+                                         _mm256_mul_epu32(_mm256_srli_epi64(q, 32), c));
+        sum = _mm256_add_epi64(sum, _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32)));
+    }
+    alignas(32) std::int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+#endif
+
+// Function to compute the exact total value sum(quantity[i] * cents[i]) of a column
+inline Money columnValue(const std::int32_t* quantity, const std::int64_t* cents, std::size_t n) {
+    std::size_t i = 0;
+    std::int64_t total = 0;
+#ifdef IMS_HAVE_AVX2
+    if (useAvx2()) {
+        total = columnValueAvx2(quantity, cents, n);
+        i = n - n % 4;
+    }
+#endif
+    for (; i < n; ++i) total += static_cast<std::int64_t>(quantity[i]) * cents[i];
+    return Money::fromCents(total);
+}
+
+// Helper function to scale one amount by numerator / denominator with 128-bit integers, rounding
+// half up (floor division), for amounts too large for the double path
+inline std::int64_t scaleWide(std::int64_t c, std::int64_t numerator, std::int64_t denominator) {
+    __int128 x = static_cast<__int128>(c) * numerator + denominator / 2;
+    __int128 q = x / denominator;
+    if (x % denominator != 0 && x < 0) --q; // Floor division
+    return static_cast<std::int64_t>(q);
+}
+
+#ifdef IMS_HAVE_AVX2
+// Helper function: AVX2 part of scaleColumn over the first n - n % 4 amounts
+__attribute__((target("avx2"))) inline void scaleColumnAvx2(std::int64_t* cents, std::size_t n, std::int64_t numerator,
+                                                           std::int64_t denominator, std::int64_t limit) {
+    const __m256i magicInt = _mm256_set1_epi64x(0x4338000000000000LL); // 2^52 + 2^51 as a double
+    const __m256d magic = _mm256_castsi256_pd(magicInt);
+    const __m256i bound = _mm256_set1_epi64x(limit);
+    const __m256i negativeBound = _mm256_set1_epi64x(-limit);
+    const __m256d vnum = _mm256_set1_pd(static_cast<double>(numerator));
+    const __m256d vden = _mm256_set1_pd(static_cast<double>(denominator));
+    const __m256d vhalf = _mm256_set1_pd(static_cast<double>(denominator / 2));
+    for (std::size_t i = 0; i + 4 <= n; i += 4) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cents + i));
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(c, bound), _mm256_cmpgt_epi64(negativeBound, c));
+        if (!_mm256_testz_si256(outside, outside)) {
+            for (std::size_t k = i; k < i + 4; ++k) cents[k] = scaleWide(cents[k], numerator, denominator);
+            continue;
+        }
+        __m256d value = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(c, magicInt)), magic);
+        __m256d scaled = _mm256_floor_pd(_mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(value, vnum), vhalf), vden));
+        __m256i result = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(scaled, magic)), magicInt);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(cents + i), result);
+    }
+}
+#endif
+
+// Function to multiply every amount by numerator / denominator, rounding half up to whole cents.
+// In doubles c * numerator + denominator / 2 is exact, and so is the floored quotient, as long as
+// everything stays within 2^51; amounts outside that limit use 128-bit integer arithmetic.
+inline void scaleColumn(std::int64_t* cents, std::size_t n, std::int64_t numerator, std::int64_t denominator) {
+    std::int64_t limit = -1; // Largest |amount| the double path handles exactly
+    if (numerator > 0 && denominator > 0 && denominator < (std::int64_t(1) << 50))
+        limit = ((std::int64_t(1) << 51) - denominator) / numerator;
+    const double num = static_cast<double>(numerator), den = static_cast<double>(denominator);
+    const double half = static_cast<double>(denominator / 2);
+    std::size_t i = 0;
+#ifdef IMS_HAVE_AVX2
+    if (limit >= 0 && useAvx2()) {
+        scaleColumnAvx2(cents, n, numerator, denominator, limit);
+        i = n - n % 4;
+    }
+#endif
+    for (; i < n; ++i) {
+        std::int64_t c = cents[i];
+        if (c <= limit && -c <= limit)
+            cents[i] = static_cast<std::int64_t>(std::floor((static_cast<double>(c) * num + half) / den));
+        else
+            cents[i] = scaleWide(c, numerator, denominator);
+    }
+}
+
+// Function to take basisPoints (1/100 of a percent) off every amount
+inline void discountColumn(std::int64_t* cents, std::size_t n, int basisPoints) {
+    scaleColumn(cents, n, 10000 - basisPoints, 10000);
+}
+
+// Function to convert every amount with an exchange rate given in millionths (1.084 -> 1084000)
+inline void convertColumn(std::int64_t* cents, std::size_t n, std::int64_t rateMicros) {
+    scaleColumn(cents, n, rateMicros, 1000000);
+}
+
+// Common data shared by every inventory item. Categories derive from it without virtual
+// functions: they are registered at compile time in ItemStore, so calls are resolved statically.
 class InventoryItem {
 public:
     std::string name;
     int quantity;
-    float price;
+    Money price;
+    std::uint32_t lastAccess = 0; // When the item was last looked up or changed (ItemStore clock)
 
     // Constructor to initialize an inventory item
-    InventoryItem(std::string n, int q, float p) : name(n), quantity(q), price(p) {}
+    InventoryItem(std::string n, int q, Money p) : name(std::move(n)), quantity(q), price(p) {}
 
-    // Virtual destructor to ensure proper cleanup of derived class objects
-    virtual ~InventoryItem() = default;
-
-    // Virtual function to display the item details, to be overridden in derived classes
-    virtual void display() const {
+    // Function to display the common item details, extended by each category
+    void display() const {
         std::cout << name << "\t" << quantity << "\t" << price << "\n";
     }
-
-    // Pure virtual function to get the item type (for polymorphism)
-    virtual std::string getType() const = 0; 
 };
 
-// Derived class: Electronics (inherits from InventoryItem)
+// Category: Electronics
 class Electronic : public InventoryItem {
 public:
     int warranty; // Warranty in months
 
+    static constexpr const char* DETAIL_PROMPT = "Enter warranty (months): ";
+    static constexpr const char* DETAIL_UNIT = "months";
+    static constexpr int DEFAULT_DETAIL = 12; // Warranty assumed when loading a file without details
+
     // Constructor to initialize an electronic item
-    Electronic(std::string n, int q, float p, int w) : InventoryItem(n, q, p), warranty(w) {}
+    Electronic(std::string n, int q, Money p, int w) : InventoryItem(std::move(n), q, p), warranty(w) {}
 
-    // Override the display function to include warranty details
-    void display() const override {
+    // Function to display the item including warranty details
+    void display() const {
         std::cout << "Electronic: ";
         InventoryItem::display();
         std::cout << "\tWarranty: " << warranty << " months\n";
     }
 
-    // Override the getType function to return the specific type
-    std::string getType() const override { return "Electronic"; }
+    // Function to get the category name (a string literal, so no allocation)
+    static constexpr const char* getType() { return "Electronic"; }
+
+    // Function to get the type-specific detail (warranty)
+    int getDetail() const { return warranty; }
 };
 
-// Derived class: Perishables (inherits from InventoryItem)
+// Category: Perishables
 class Perishable : public InventoryItem {
 public:
     int shelfLife; // Shelf life in days
 
+    static constexpr const char* DETAIL_PROMPT = "Enter shelf life (days): ";
+    static constexpr const char* DETAIL_UNIT = "days";
+    static constexpr int DEFAULT_DETAIL = 7; // Shelf life assumed when loading a file without details
+
     // Constructor to initialize a perishable item
-    Perishable(std::string n, int q, float p, int s) : InventoryItem(n, q, p), shelfLife(s) {}
+    Perishable(std::string n, int q, Money p, int s) : InventoryItem(std::move(n), q, p), shelfLife(s) {}
 
-    // Override the display function to include shelf life details
-    void display() const override {
+    // Function to display the item including shelf life details
+    void display() const {
         std::cout << "Perishable: ";
         InventoryItem::display();
         std::cout << "\tShelf Life: " << shelfLife << " days\n";
     }
 
-    // Override the getType function to return the specific type
-    std::string getType() const override { return "Perishable"; }
+    // Function to get the category name (a string literal, so no allocation)
+    static constexpr const char* getType() { return "Perishable"; }
+
+    // Function to get the type-specific detail (shelf life)
+    int getDetail() const { return shelfLife; }
 };
 
-// Transaction class to track changes in inventory
-class Transaction {
-public:
-    std::string name, type; // name of the item and the type of transaction (added/removed)
-    
-    // Constructor to initialize a transaction
-    Transaction(std::string n, std::string t) : name(n), type(t) {}
+// Tag used to pass a category type through a generic lambda
+template <typename T>
+struct CategoryTag {
+    using type = T;
 };
 
-// Queue for order management, where orders are processed in a FIFO manner
-class OrderQueue {
-    std::queue<std::string> orders; // Queue to store orders
+// Frame-of-reference bit-packed integer column: each value is stored as (value - base) in just
+// enough bits for the column's range
+class PackedInts {
+    std::int64_t base = 0;
+    unsigned bits = 0;
+    std::vector<std::uint64_t> words;
 
 public:
-    // Function to add an order to the queue
-    void addOrder(const std::string& order) {
-        orders.push(order);
-        std::cout << "Order added: " << order << "\n";
+    // Function to pack a column of values
+    void encode(const std::vector<std::int64_t>& values) {
+        base = 0;
+        bits = 0;
+        words.clear();
+        if (values.empty()) return;
+        auto range = std::minmax_element(values.begin(), values.end());
+        base = *range.first;
+        std::uint64_t span = static_cast<std::uint64_t>(*range.second) - static_cast<std::uint64_t>(base);
+        while (bits < 64 && (span >> bits) != 0) ++bits;
+        words.assign((values.size() * bits + 63) / 64, 0);
+        for (std::size_t i = 0; i < values.size() && bits; ++i) {
+            std::uint64_t v = static_cast<std::uint64_t>(values[i]) - static_cast<std::uint64_t>(base);
+            std::size_t bit = i * bits, word = bit / 64, offset = bit % 64;
+            words[word] |= v << offset;
+            if (offset + bits > 64) words[word + 1] |= v >> (64 - offset);
+        }
+        words.shrink_to_fit();
     }
 
-    // Function to process an order from the queue (FIFO)
-    void processOrder() {
-        if (orders.empty()) {
-            std::cout << "No orders to process.\n";
-            return;
+    // Function to read value i
+    std::int64_t get(std::size_t i) const {
+        if (!bits) return base;
+        std::size_t bit = i * bits, word = bit / 64, offset = bit % 64;
+        std::uint64_t v = words[word] >> offset;
+        if (offset + bits > 64) v |= words[word + 1] << (64 - offset);
+        if (bits < 64) v &= (std::uint64_t(1) << bits) - 1;
+        return static_cast<std::int64_t>(static_cast<std::uint64_t>(base) + v);
+    }
+
+    // Function to get the heap memory used by the column
+    std::size_t bytes() const { return words.capacity() * sizeof(std::uint64_t); }
+};
+
+// Compressed storage for items of category C that have not been touched for a while.
+// Items are sorted by name and packed into blocks: names are front-coded (each name stores only
+// what differs from the previous one), and quantities, details and prices (in cents) are
+// bit-packed. Blocks never overlap, so a lookup decodes at most one block.
+template <typename C>
+class ColdShelf {
+public:
+    static constexpr std::size_t BLOCK_ITEMS = 256;
+
+private:
+    struct Block {
+        std::string lastName;          // Largest name in the block, for binary search
+        std::vector<char> names;       // Front-coded names: shared length, suffix length, suffix
+        PackedInts quantities, cents, details;
+        std::vector<bool> removed;     // Items taken out since the block was built
+        std::size_t live = 0;
+    };
+
+    std::vector<Block> blocks; // Sorted by name
+    std::size_t live = 0;      // Items in all blocks that have not been removed
+
+    static void putLength(std::vector<char>& out, std::size_t n) {
+        do {
+            char byte = static_cast<char>(n & 0x7f);
+            n >>= 7;
+            out.push_back(static_cast<char>(byte | (n ? 0x80 : 0)));
+        } while (n);
+    }
+
+    static std::size_t getLength(const std::vector<char>& in, std::size_t& at) {
+        std::size_t n = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            unsigned char byte = static_cast<unsigned char>(in[at++]);
+            n |= static_cast<std::size_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return n;
         }
-        std::cout << "Processing order: " << orders.front() << "\n";
-        orders.pop();
     }
 
-    // Function to display all pending orders
-    void displayOrders() {
-        if (orders.empty()) {
-            std::cout << "No pending orders.\n";
-            return;
+    // Helper function to decode the next front-coded name into name
+    static void nextName(const std::vector<char>& names, std::size_t& at, std::string& name) {
+        std::size_t shared = getLength(names, at);
+        std::size_t suffix = getLength(names, at);
+        name.resize(shared);
+        name.append(names.data() + at, suffix);
+        at += suffix;
+    }
+
+    static Block encode(const std::vector<C>& items, std::size_t first, std::size_t count) {
+        Block block;
+        std::vector<std::int64_t> quantities, cents, details;
+        const std::string* previous = nullptr;
+        for (std::size_t i = first; i < first + count; ++i) {
+            const C& item = items[i];
+            std::size_t shared = 0;
+            if (previous) {
+                while (shared < previous->size() && shared < item.name.size() && (*previous)[shared] == item.name[shared])
+                    ++shared;
+            }
+            putLength(block.names, shared);
+            putLength(block.names, item.name.size() - shared);
+            block.names.insert(block.names.end(), item.name.begin() + shared, item.name.end());
+            previous = &item.name;
+            quantities.push_back(item.quantity);
+            cents.push_back(item.price.toCents());
+            details.push_back(item.getDetail());
         }
-        std::queue<std::string> temp = orders; // Temporary copy to display orders
-        std::cout << "Pending orders:\n";
-        while (!temp.empty()) {
-            std::cout << temp.front() << "\n";
-            temp.pop();
+        block.names.shrink_to_fit();
+        block.lastName = items[first + count - 1].name;
+        block.quantities.encode(quantities);
+        block.cents.encode(cents);
+        block.details.encode(details);
+        block.removed.assign(count, false);
+        block.live = count;
+        return block;
+    }
+
+    // Helper function to call f(slot, item) for every live item of a block
+    template <typename F>
+    static void decode(const Block& block, F&& f) {
+        std::string name;
+        std::size_t at = 0;
+        for (std::size_t slot = 0; slot < block.removed.size(); ++slot) {
+            nextName(block.names, at, name);
+            if (block.removed[slot]) continue;
+            f(slot, C(name, static_cast<int>(block.quantities.get(slot)), Money::fromCents(block.cents.get(slot)),
+                      static_cast<int>(block.details.get(slot))));
+        }
+    }
+
+    // Helper function to locate a live item; returns false if it is not cold
+    bool locate(const std::string& name, std::size_t& blockIndex, std::size_t& slot) const {
+        auto found = std::lower_bound(blocks.begin(), blocks.end(), name,
+                                      [](const Block& block, const std::string& key) { return block.lastName < key; });
+        if (found == blocks.end()) return false;
+        std::string current;
+        std::size_t at = 0;
+        for (slot = 0; slot < found->removed.size(); ++slot) {
+            nextName(found->names, at, current);
+            if (current == name) {
+                blockIndex = static_cast<std::size_t>(found - blocks.begin());
+                return !found->removed[slot];
+            }
+            if (current > name) return false;
+        }
+        return false;
+    }
+
+    // Helper function to encode a sorted list of items into blocks of similar size, at most
+    // BLOCK_ITEMS each
+    static void encodeInto(std::vector<Block>& out, const std::vector<C>& items) {
+        std::size_t count = (items.size() + BLOCK_ITEMS - 1) / BLOCK_ITEMS;
+        for (std::size_t k = 0; k < count; ++k) {
+            std::size_t first = items.size() * k / count, last = items.size() * (k + 1) / count;
+            out.push_back(encode(items, first, last - first));
+        }
+    }
+
+    // Helper function to call f on every live item of a block and re-encode the block only if
+    // f changed an item; returns how many items it holds
+    template <typename F>
+    std::size_t update(std::size_t blockIndex, F& f) {
+        Block& block = blocks[blockIndex];
+        std::vector<C> items;
+        items.reserve(block.live);
+        bool changed = false;
+        decode(block, [&](std::size_t slot, C item) {
+            f(item);
+            changed = changed || item.quantity != block.quantities.get(slot) ||
+                      item.price.toCents() != block.cents.get(slot) || item.getDetail() != block.details.get(slot);
+            items.push_back(std::move(item));
+        });
+        if (changed) block = encode(items, 0, items.size()); // Names are unchanged, so blocks stay sorted
+        return items.size();
+    }
+
+public:
+    // Function to move items into the compressed tier. Each item is merged into the block whose
+    // name range holds it; only those blocks are decoded and re-encoded (split if they overflow),
+    // and items past the last block form new blocks.
+    void freeze(std::vector<C> items) {
+        if (items.empty()) return;
+        std::sort(items.begin(), items.end(), [](const C& a, const C& b) { return a.name < b.name; });
+        live += items.size();
+        std::vector<Block> merged;
+        merged.reserve(blocks.size() + items.size() / BLOCK_ITEMS + 1);
+        auto next = items.begin();
+        for (auto& block : blocks) {
+            auto end = std::upper_bound(next, items.end(), block.lastName,
+                                        [](const std::string& name, const C& item) { return name < item.name; });
+            if (next == end) {
+                merged.push_back(std::move(block));
+                continue;
+            }
+            std::vector<C> combined;
+            combined.reserve(block.live + static_cast<std::size_t>(end - next));
+            decode(block, [&](std::size_t, C item) {
+                for (; next != end && next->name < item.name; ++next) combined.push_back(std::move(*next));
+                combined.push_back(std::move(item));
+            });
+            for (; next != end; ++next) combined.push_back(std::move(*next));
+            encodeInto(merged, combined);
+        }
+        if (next != items.end())
+            encodeInto(merged, std::vector<C>(std::make_move_iterator(next), std::make_move_iterator(items.end())));
+        blocks = std::move(merged);
+    }
+
+    // Function to check whether a name is in the cold tier
+    bool contains(const std::string& name) const {
+        std::size_t blockIndex, slot;
+        return locate(name, blockIndex, slot);
+    }
+
+    // Function to take an item out of the cold tier (decompressing it); returns false if absent
+    bool take(const std::string& name, std::vector<C>& out) {
+        std::size_t blockIndex, slot;
+        if (!locate(name, blockIndex, slot)) return false;
+        Block& block = blocks[blockIndex];
+        out.emplace_back(name, static_cast<int>(block.quantities.get(slot)), Money::fromCents(block.cents.get(slot)),
+                         static_cast<int>(block.details.get(slot)));
+        block.removed[slot] = true;
+        --live;
+        if (--block.live == 0) blocks.erase(blocks.begin() + blockIndex);
+        return true;
+    }
+
+    // Function to call f on every cold item (decoded copies)
+    template <typename F>
+    void forEach(F& f) const {
+        for (const auto& block : blocks) decode(block, [&](std::size_t, const C& item) { f(item); });
+    }
+
+    // Function to call f on every cold item and store any quantity or price changes back; only
+    // blocks with a changed item are re-encoded
+    template <typename F>
+    void forEachMutable(F& f) {
+        for (std::size_t b = 0; b < blocks.size(); ++b) update(b, f);
+    }
+
+    std::size_t size() const { return live; }
+
+    // Function to count the compressed blocks; blocks can be processed in parallel
+    std::size_t blockCount() const { return blocks.size(); }
+
+    // Function to call f on every live item of one block (decoded copies); returns how many
+    template <typename F>
+    std::size_t forEachInBlock(std::size_t blockIndex, F& f) const {
+        decode(blocks[blockIndex], [&](std::size_t, const C& item) { f(item); });
+        return blocks[blockIndex].live;
+    }
+
+    // Function to call f on every live item of one block and store the changes back by
+    // re-encoding only that block, if anything changed; returns how many items it holds
+    template <typename F>
+    std::size_t forEachInBlock(std::size_t blockIndex, F& f) { return update(blockIndex, f); }
+
+    // Function to estimate the memory used by the cold tier
+    std::size_t bytes() const {
+        std::size_t total = blocks.capacity() * sizeof(Block);
+        for (const auto& block : blocks) {
+            total += block.names.capacity() + block.lastName.capacity() + block.removed.capacity() / 8;
+            total += block.quantities.bytes() + block.cents.bytes() + block.details.bytes();
         }
+        return total;
+    }
+
+    void clear() {
+        blocks.clear();
+        live = 0;
     }
 };
 
-// Inventory Manager to manage inventory and orders
-class InventoryManager {
-    std::vector<InventoryItem*> inventory; // List of inventory items
-    std::vector<Transaction> transactions; // List of transactions (added/removed)
-    OrderQueue orderQueue; // Object to manage orders
+// Cancellation flag shared by whoever starts a bulk operation and the tasks running it. Copies
+// share the flag; tasks check it between chunks of work.
+class CancellationToken {
+    std::shared_ptr<std::atomic<bool>> flag = std::make_shared<std::atomic<bool>>(false);
 
 public:
-    // Destructor to clean up dynamically allocated memory for inventory items
-    ~InventoryManager() {
-        for (auto item : inventory) delete item;
+    void cancel() const { flag->store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return flag->load(std::memory_order_relaxed); }
+
+    // Function to get the flag itself, e.g. for a signal handler to set
+    std::atomic<bool>* raw() const { return flag.get(); }
+};
+
+// Cancels a token when the user presses Ctrl+C, for as long as this object exists
+class InterruptCancels {
+    static inline std::atomic<std::atomic<bool>*> target{nullptr};
+    void (*previous)(int);
+
+    static void handle(int) {
+        if (std::atomic<bool>* flag = target.load()) flag->store(true);
     }
 
-    // Function to add an item to the inventory
-    void addItem() {
-        try {
-            std::string name, type;
-            int quantity; 
-            float price;
-            std::cout << "Enter item type (Electronic/Perishable): ";
-            std::getline(std::cin, type);
-            std::cout << "Enter name: "; 
-            std::getline(std::cin, name);
-            std::cout << "Enter quantity: "; 
-            std::cin >> quantity;
-            if (quantity < 0) throw std::invalid_argument("Quantity cannot be negative.");
-            std::cout << "Enter price: "; 
-            std::cin >> price;
-            if (price < 0) throw std::invalid_argument("Price cannot be negative.");
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
+public:
+    explicit InterruptCancels(const CancellationToken& token) {
+        target = token.raw();
+        previous = std::signal(SIGINT, handle);
+    }
+    ~InterruptCancels() {
+        std::signal(SIGINT, previous == SIG_ERR ? SIG_DFL : previous);
+        target = nullptr;
+    }
+    InterruptCancels(const InterruptCancels&) = delete;
+    InterruptCancels& operator=(const InterruptCancels&) = delete;
+};
 
-            // Handle different item types
-            if (type == "Electronic") {
-                int warranty;
-                std::cout << "Enter warranty (months): "; 
-                std::cin >> warranty;
-                inventory.push_back(new Electronic(name, quantity, price, warranty));
-            } else if (type == "Perishable") {
-                int shelfLife;
-                std::cout << "Enter shelf life (days): "; 
-                std::cin >> shelfLife;
-                inventory.push_back(new Perishable(name, quantity, price, shelfLife));
-            } else {
-                throw std::invalid_argument("Invalid item type.");
+// Progress of a bulk operation over a known number of items. Tasks add what they finished from
+// any thread; the callback runs (on the thread that crossed the step, one call at a time) each
+// time another stepPercent percent is done.
+class ProgressReporter {
+    std::function<void(std::size_t done, std::size_t total)> report;
+    std::size_t total;
+    std::size_t stepPercent;
+    std::atomic<std::size_t> done{0};
+    std::atomic<std::size_t> reported{0}; // Percent last reported
+    std::mutex mtx;
+
+public:
+    ProgressReporter(std::size_t totalItems, std::function<void(std::size_t, std::size_t)> callback, std::size_t step = 1)
+        : report(std::move(callback)), total(totalItems), stepPercent(std::max<std::size_t>(step, 1)) {}
+
+    // Function to record that items more items are finished
+    void advance(std::size_t items) {
+        std::size_t now = done.fetch_add(items, std::memory_order_relaxed) + items;
+        std::size_t percent = total ? std::min<std::size_t>(now * 100 / total, 100) : 100;
+        percent -= percent % stepPercent;
+        std::size_t last = reported.load(std::memory_order_relaxed);
+        while (percent > last) {
+            if (reported.compare_exchange_weak(last, percent)) {
+                std::lock_guard<std::mutex> lock(mtx);
+                report(now, total);
+                return;
             }
-            transactions.emplace_back(name, "Added");
-            std::cout << "Item added successfully.\n";
-        } catch (const std::exception& e) {
-            std::cout << "Error: " << e.what() << "\n";
         }
     }
 
-    // Function to remove an item from the inventory
-    void removeItem() {
-        try {
-            if (inventory.empty()) throw std::runtime_error("No items in inventory.");
-            std::string name;
-            std::cout << "Enter name of the item to remove: ";
-            std::getline(std::cin, name);
+    std::size_t completed() const { return done.load(std::memory_order_relaxed); }
+};
 
-            // Find and remove the item from the inventory
-            for (auto it = inventory.begin(); it != inventory.end(); ++it) {
-                if ((*it)->name == name) {
-                    delete *it; // Free memory
-                    inventory.erase(it); // Remove from the vector
-                    transactions.emplace_back(name, "Removed");
-                    std::cout << "Item removed successfully.\n";
-                    return;
-                }
+// Work-stealing task pool for bulk operations. Each thread owns a deque of tasks: it pushes and
+// pops its own tasks at the back (newest first, still warm in its cache) and, when it runs dry,
+// steals the oldest task (usually the largest remaining range) from the front of another deque.
+// Threads outside the pool share deque 0 and run tasks themselves while they wait, so a pool of
+// N threads has N - 1 workers plus the caller, and a pool of 1 runs everything on the caller.
+class WorkStealingPool {
+    struct Queue {
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // Queue 0 belongs to outside threads, queue i to worker i
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queued{0}; // Tasks waiting in all deques
+    std::atomic<std::size_t> stolen{0};
+    std::mutex sleepMtx;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    static inline thread_local const WorkStealingPool* currentPool = nullptr;
+    static inline thread_local std::size_t currentQueue = 0;
+
+    std::size_t self() const { return currentPool == this ? currentQueue : 0; }
+
+    // Helper function to take a task from a deque, the newest or the oldest one
+    bool take(std::size_t from, bool newest, std::function<void()>& task) {
+        Queue& queue = *queues[from];
+        std::lock_guard<std::mutex> lock(queue.mtx);
+        if (queue.tasks.empty()) return false;
+        if (newest) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Helper function to run one task, from the own deque or stolen; returns false if there was none
+    bool runOne() {
+        std::size_t me = self();
+        std::function<void()> task;
+        if (!take(me, true, task)) {
+            for (std::size_t k = 1; k < queues.size() && !task; ++k) {
+                if (take((me + k) % queues.size(), false, task)) stolen.fetch_add(1, std::memory_order_relaxed);
             }
-            throw std::runtime_error("Item not found.");
-        } catch (const std::exception& e) {
-            std::cout << "Error: " << e.what() << "\n";
+            if (!task) return false;
         }
+        task();
+        return true;
     }
 
-    // Function to display all items in the inventory
-    void displayInventory() const {
-        if (inventory.empty()) {
-            std::cout << "No items in inventory.\n";
-            return;
+    void work(std::size_t index) {
+        currentPool = this;
+        currentQueue = index;
+        for (;;) {
+            if (runOne()) continue;
+            std::unique_lock<std::mutex> lock(sleepMtx);
+            wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+            if (stopping) return;
         }
-        std::cout << "Inventory:\n";
-        for (const auto& item : inventory) item->display();
     }
 
-    // Function to save inventory data to a file
-    void saveToFile() {
-        try {
-            std::ofstream outFile("inventory.txt");
-            if (!outFile) throw std::ios_base::failure("Error opening file.");
-            for (const auto& item : inventory) {
-                outFile << item->getType() << "," << item->name << "," << item->quantity << "," << item->price << "\n";
-            }
-            outFile.close();
-            std::cout << "Inventory saved to file.\n";
-        } catch (const std::exception& e) {
-            std::cout << "Error: " << e.what() << "\n";
+public:
+    explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency()) {
+        threads = std::max(threads, 1u);
+        for (unsigned i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+        for (unsigned i = 1; i < threads; ++i) workers.emplace_back(&WorkStealingPool::work, this, i);
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMtx);
+            stopping = true;
         }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
     }
 
-    // Function to load inventory data from a file
-    void loadFromFile() {
-        try {
-            std::ifstream inFile("inventory.txt");
-            if (!inFile) throw std::ios_base::failure("Error opening file.");
-            inventory.clear(); // Clear the current inventory
-            std::string type, name; 
-            int quantity; 
-            float price;
-            while (inFile >> type) {
-                std::getline(inFile, name, ','); // Read name
-                inFile >> quantity >> price;
-                if (type == "Electronic") 
-                    inventory.push_back(new Electronic(name, quantity, price, 12));
-                else if (type == "Perishable") 
-                    inventory.push_back(new Perishable(name, quantity, price, 7));
-            }
-            inFile.close();
-            std::cout << "Inventory loaded from file.\n";
-        } catch (const std::exception& e) {
-            std::cout << "Error: " << e.what() << "\n";
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Function to count the threads that run tasks, including the caller
+    std::size_t size() const { return queues.size(); }
+
+    // Function to count the tasks taken from another thread's deque since the pool started
+    std::size_t steals() const { return stolen.load(std::memory_order_relaxed); }
+
+    // Function to queue a task on the calling thread's deque
+    void spawn(std::function<void()> task) {
+        Queue& queue = *queues[self()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            queue.tasks.push_back(std::move(task));
         }
+        queued.fetch_add(1);
+        { std::lock_guard<std::mutex> lock(sleepMtx); } // A worker about to sleep sees the task first
+        wake.notify_one();
     }
 
-    // Function to manage orders
-    void manageOrders() {
-        int choice;
-        do {
-            std::cout << "1. Add Order\n2. Process Order\n3. Display Orders\n4. Back to Main Menu\n";
-            std::cin >> choice; 
-            std::cin.ignore();
-            switch (choice) {
-                case 1: {
-                    std::string order;
-                    std::cout << "Enter order name: "; 
-                    std::getline(std::cin, order);
-                    orderQueue.addOrder(order);
-                    break;
-                }
-                case 2: 
-                    orderQueue.processOrder(); 
-                    break;
-                case 3: 
-                    orderQueue.displayOrders(); 
-                    break;
-                case 4: 
-                    return;
-                default: 
-                    std::cout << "Invalid choice.\n";
+    // Function to run tasks until pending drops to zero
+    void helpUntil(const std::atomic<std::size_t>& pending) {
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (!runOne()) std::this_thread::yield();
+        }
+    }
+
+    // Function to call body(lo, hi) on pieces of at most grain indexes covering [begin, end), in
+    // parallel, and wait for all of them. A range is split in halves on demand: the running task
+    // keeps the lower half and offers the upper half for stealing, so idle threads take large
+    // pieces. Once the token is cancelled no further pieces start. If body throws, the pieces not
+    // yet started are skipped and the first exception is rethrown here.
+    template <typename Body>
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, Body&& body,
+                     const CancellationToken& token = CancellationToken()) {
+        if (begin >= end) return;
+        grain = std::max<std::size_t>(grain, 1);
+        std::atomic<std::size_t> pending{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex errorMtx;
+        std::function<void(std::size_t, std::size_t)> run = [&](std::size_t lo, std::size_t hi) {
+            while (hi - lo > grain) {
+                std::size_t mid = lo + (hi - lo) / 2;
+                pending.fetch_add(1, std::memory_order_relaxed);
+                spawn([&run, &pending, mid, hi] {
+                    run(mid, hi);
+                    pending.fetch_sub(1, std::memory_order_release);
+                });
+                hi = mid;
             }
-        } while (choice != 4);
+            if (token.cancelled() || failed.load(std::memory_order_relaxed)) return;
+            try {
+                body(lo, hi);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMtx);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        };
+        run(begin, end);
+        helpUntil(pending);
+        if (error) std::rethrow_exception(error);
     }
 
-    // Helper function to get an integer input with validation
-    int getIntInput(const std::string& prompt) {
-        int value;
-        std::cout << prompt;
-        while (!(std::cin >> value)) {
-            std::cin.clear(); 
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::cout << "Invalid input. Please enter a valid integer: ";
-        }
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
-        return value;
+    // Function to reduce [begin, end) in parallel: map(lo, hi) computes the result of one piece and
+    // combine merges two results. Pieces finish in any order, so combine must be associative and
+    // commutative.
+    template <typename T, typename Map, typename Combine>
+    T parallelReduce(std::size_t begin, std::size_t end, std::size_t grain, T identity, Map&& map, Combine&& combine,
+                     const CancellationToken& token = CancellationToken()) {
+        T result = std::move(identity);
+        std::mutex mtx;
+        parallelFor(begin, end, grain, [&](std::size_t lo, std::size_t hi) {
+            T part = map(lo, hi);
+            std::lock_guard<std::mutex> lock(mtx);
+            result = combine(std::move(result), std::move(part));
+        }, token);
+        return result;
     }
 };
 
-// Main function where the program starts
-int main() {
-    InventoryManager manager;
-    int choice;
-
-    do {
-        std::cout << "\nInventory Management System\n";
-        std::cout << "1. Add Item\n2. Remove Item\n3. Display Inventory\n4. Save to File\n5. Load from File\n6. Manage Orders\n7. Exit\n";
-        choice = manager.getIntInput("Choose an option: ");
-        
-        switch (choice) {
-            case 1: manager.addItem(); break;
-            case 2: manager.removeItem(); break;
-            case 3: manager.displayInventory(); break;
-            case 4: manager.saveToFile(); break;
-            case 5: manager.loadFromFile(); break;
-            case 6: manager.manageOrders(); break;
-            case 7: std::cout << "Exiting program.\n"; break;
-            default: std::cout << "Invalid choice.\n"; break;
-        }
-    } while (choice != 7);
+// Compile-time registry of item categories. Each category is kept in its own homogeneous vector,
+// so bulk operations become one statically dispatched loop per category. Adding a category only
+// adds another loop; it does not slow down the existing ones. A hash index maps names to items.
+// Items left untouched for a while can be frozen into a compressed cold tier per category; they are
+// decompressed transparently when they are looked up again.
+template <typename... Categories>
+class ItemStore {
+    // Position of an item: which category vector, and where in it
+    struct Location {
+        std::size_t category;
+        std::size_t position;
+    };
+
+    std::tuple<std::vector<Categories>...> shelves; // One vector per category (hot tier)
+    std::tuple<ColdShelf<Categories>...> cold;       // Compressed items per category (cold tier)
+    std::unordered_map<std::string, Location> index; // Hot item name -> location
+
+public:
+    // Function to read the clock used for lastAccess (seconds since the program started)
+    static std::uint32_t now() {
+        static const auto start = std::chrono::steady_clock::now();
+        return static_cast<std::uint32_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // Function to read the vector holding the hot items of one category
+    template <typename C>
+    const std::vector<C>& shelf() const { return std::get<std::vector<C>>(shelves); }
+
+    // Function to call f on every item; f is instantiated once per category.
+    // f may change quantities and prices but must not rename items.
+    template <typename F>
+    void forEach(F&& f) const {
+        std::apply([&](const auto&... shelf) { (forEachIn(shelf, f), ...); }, shelves);
+        std::apply([&](const auto&... coldShelf) { (coldShelf.forEach(f), ...); }, cold);
+    }
+
+    template <typename F>
+    void forEach(F&& f) {
+        std::apply([&](auto&... shelf) { (forEachIn(shelf, f), ...); }, shelves);
+        std::apply([&](auto&... coldShelf) { (coldShelf.forEachMutable(f), ...); }, cold);
+    }
+
+    // Function to call f on every item in parallel on pool. As with forEach, f is instantiated once
+    // per category and may change quantities and prices, but it runs concurrently on different
+    // items. Finished items are added to progress, if given. Once the token is cancelled no further
+    // chunks start, so a cancelled call may have visited only some of the items.
+    template <typename F>
+    void parallelForEach(WorkStealingPool& pool, F&& f, const CancellationToken& token = CancellationToken(),
+                         ProgressReporter* progress = nullptr) const {
+        std::apply([&](const auto&... shelf) { (parallelShelf(pool, shelf, f, token, progress), ...); }, shelves);
+        std::apply([&](const auto&... coldShelf) { (parallelCold(pool, coldShelf, f, token, progress), ...); }, cold);
+    }
+
+    template <typename F>
+    void parallelForEach(WorkStealingPool& pool, F&& f, const CancellationToken& token = CancellationToken(),
+                         ProgressReporter* progress = nullptr) {
+        std::apply([&](auto&... shelf) { (parallelShelf(pool, shelf, f, token, progress), ...); }, shelves);
+        std::apply([&](auto&... coldShelf) { (parallelCold(pool, coldShelf, f, token, progress), ...); }, cold);
+    }
+
+    // Function to reduce all items in parallel on pool: fold(part, item) adds one item to the
+    // partial result of a chunk, and combine merges two partial results (associative and
+    // commutative, since chunks finish in any order)
+    template <typename T, typename Fold, typename Combine>
+    T parallelReduce(WorkStealingPool& pool, T identity, Fold&& fold, Combine&& combine,
+                     const CancellationToken& token = CancellationToken(), ProgressReporter* progress = nullptr) const {
+        T result = identity;
+        auto reduceIn = [&](std::size_t count, std::size_t grain, auto&& foldRange) {
+            result = combine(std::move(result), pool.parallelReduce(0, count, grain, identity, [&](std::size_t lo, std::size_t hi) {
+                T part = identity;
+                std::size_t items = foldRange(part, lo, hi);
+                if (progress) progress->advance(items);
+                return part;
+            }, combine, token));
+        };
+        std::apply([&](const auto&... shelf) {
+            (reduceIn(shelf.size(), PARALLEL_GRAIN, [&](T& part, std::size_t lo, std::size_t hi) {
+                 for (std::size_t i = lo; i < hi; ++i) fold(part, shelf[i]);
+                 return hi - lo;
+             }), ...);
+        }, shelves);
+        std::apply([&](const auto&... coldShelf) {
+            (reduceIn(coldShelf.blockCount(), PARALLEL_BLOCKS, [&](T& part, std::size_t lo, std::size_t hi) {
+                 std::size_t items = 0;
+                 auto add = [&](const auto& item) { fold(part, item); };
+                 for (std::size_t b = lo; b < hi; ++b) items += coldShelf.forEachInBlock(b, add);
+                 return items;
+             }), ...);
+        }, cold);
+        return result;
+    }
+
+    // Function to map a runtime category name (user input, file data) to its type;
+    // calls f(CategoryTag<C>{}) and returns false if the name is not registered
+    template <typename F>
+    static bool withCategory(const std::string& type, F&& f) {
+        bool found = false;
+        ((!found && type == Categories::getType() ? (f(CategoryTag<Categories>{}), found = true) : false), ...);
+        return found;
+    }
+
+    // Function to add an item of category C; names must be unique
+    template <typename C>
+    C& add(C item) {
+        if (contains(item.name)) throw std::invalid_argument("Item already exists.");
+        return addHot(std::move(item));
+    }
+
+    // Function to call f on the item with the given name (with its concrete type);
+    // returns false if it does not exist. A cold item is moved back to the hot tier first.
+    template <typename F>
+    bool visit(const std::string& name, F&& f) {
+        auto found = index.find(name);
+        if (found == index.end()) {
+            if (!thaw(name)) return false;
+            found = index.find(name);
+        }
+        Location at = found->second;
+        ((at.category == categoryIndex<Categories>() ? (touch(std::get<std::vector<Categories>>(shelves)[at.position], f), true)
+                                                     : false) || ...);
+        return true;
+    }
+
+    // Function to check whether an item exists
+    bool contains(const std::string& name) const {
+        if (index.count(name)) return true;
+        return std::apply([&](const auto&... coldShelf) { return (coldShelf.contains(name) || ...); }, cold);
+    }
+
+    // Function to remove the item with the given name; returns false if it does not exist.
+    // The last item of the category takes its place, so removal is O(1).
+    bool remove(const std::string& name) {
+        auto found = index.find(name);
+        if (found == index.end()) {
+            if (!thaw(name)) return false;
+            found = index.find(name);
+        }
+        Location at = found->second;
+        index.erase(found);
+        ((at.category == categoryIndex<Categories>() ? (removeAt(std::get<std::vector<Categories>>(shelves), at.position), true)
+                                                     : false) || ...);
+        return true;
+    }
+
+    // Function to count the items of all categories
+    std::size_t size() const { return index.size() + coldSize(); }
+
+    bool empty() const { return size() == 0; }
+
+    // Function to count the items in the cold tier
+    std::size_t coldSize() const {
+        return std::apply([](const auto&... coldShelf) { return (coldShelf.size() + ... + 0); }, cold);
+    }
+
+    // Function to estimate the memory used by the cold tier
+    std::size_t coldBytes() const {
+        return std::apply([](const auto&... coldShelf) { return (coldShelf.bytes() + ... + 0); }, cold);
+    }
+
+    // Function to compress every item not looked up or changed for idleSeconds; returns how many
+    std::size_t freezeIdle(std::uint32_t idleSeconds) {
+        std::size_t frozen = 0;
+        std::uint32_t current = now();
+        std::apply([&](auto&... shelf) { ((frozen += freezeFrom(shelf, current, idleSeconds)), ...); }, shelves);
+        if (frozen) index.rehash(0); // Let the index give back the buckets of frozen items
+        return frozen;
+    }
+
+    // Function to remove every item
+    void clear() {
+        std::apply([](auto&... shelf) { (shelf.clear(), ...); }, shelves);
+        std::apply([](auto&... coldShelf) { (coldShelf.clear(), ...); }, cold);
+        index.clear();
+    }
+
+private:
+    static constexpr std::size_t PARALLEL_GRAIN = 4096; // Hot items per parallel chunk
+    static constexpr std::size_t PARALLEL_BLOCKS = 4;   // Cold blocks per parallel chunk
+
+    template <typename V, typename F>
+    static void parallelShelf(WorkStealingPool& pool, V& shelf, F& f, const CancellationToken& token,
+                              ProgressReporter* progress) {
+        pool.parallelFor(0, shelf.size(), PARALLEL_GRAIN, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t i = lo; i < hi; ++i) f(shelf[i]);
+            if (progress) progress->advance(hi - lo);
+        }, token);
+    }
+
+    template <typename S, typename F>
+    static void parallelCold(WorkStealingPool& pool, S& coldShelf, F& f, const CancellationToken& token,
+                             ProgressReporter* progress) {
+        pool.parallelFor(0, coldShelf.blockCount(), PARALLEL_BLOCKS, [&](std::size_t lo, std::size_t hi) {
+            std::size_t items = 0;
+            for (std::size_t b = lo; b < hi; ++b) items += coldShelf.forEachInBlock(b, f);
+            if (progress) progress->advance(items);
+        }, token);
+    }
+
+    // Helper function giving the position of C in the category list
+    template <typename C>
+    static constexpr std::size_t categoryIndex() {
+        std::size_t i = 0, found = 0;
+        ((std::is_same<C, Categories>::value ? (found = i++) : i++), ...);
+        return found;
+    }
+
+    template <typename V, typename F>
+    static void forEachIn(V& shelf, F& f) {
+        for (auto& item : shelf) f(item);
+    }
+
+    template <typename C, typename F>
+    static void touch(C& item, F& f) {
+        item.lastAccess = now();
+        f(item);
+    }
+
+    // Helper function to put an item known not to exist into the hot tier
+    template <typename C>
+    C& addHot(C item) {
+        auto& shelf = std::get<std::vector<C>>(shelves);
+        index[item.name] = Location{categoryIndex<C>(), shelf.size()};
+        item.lastAccess = now();
+        shelf.push_back(std::move(item));
+        return shelf.back();
+    }
+
+    template <typename C>
+    void addAll(std::vector<C> items) {
+        for (auto& item : items) addHot(std::move(item));
+    }
+
+    // Helper function to move a cold item back to the hot tier; returns false if it is not cold
+    bool thaw(const std::string& name) {
+        return std::apply([&](auto&... coldShelf) { return (thawFrom(coldShelf, name) || ...); }, cold);
+    }
+
+    template <typename C>
+    bool thawFrom(ColdShelf<C>& coldShelf, const std::string& name) {
+        std::vector<C> taken;
+        if (!coldShelf.take(name, taken)) return false;
+        addAll(std::move(taken));
+        return true;
+    }
+
+    template <typename C>
+    std::size_t freezeFrom(std::vector<C>& shelf, std::uint32_t current, std::uint32_t idleSeconds) {
+        std::vector<C> idle;
+        for (std::size_t i = 0; i < shelf.size();) {
+            if (current - shelf[i].lastAccess >= idleSeconds) {
+                index.erase(shelf[i].name);
+                idle.push_back(std::move(shelf[i]));
+                removeAt(shelf, i); // Moves the last item into slot i, which is checked next
+            } else {
+                ++i;
+            }
+        }
+        std::size_t frozen = idle.size();
+        std::get<ColdShelf<C>>(cold).freeze(std::move(idle));
+        shelf.shrink_to_fit();
+        return frozen;
+    }
+
+    template <typename V>
+    void removeAt(V& shelf, std::size_t position) {
+        if (position + 1 != shelf.size()) {
+            shelf[position] = std::move(shelf.back());
+            index[shelf[position].name].position = position;
+        }
+        shelf.pop_back();
+    }
+};
+
+// Registry of all item categories known to the program
+using Inventory = ItemStore<Electronic, Perishable>;
+
+// One item as seen by the report engine
+struct ReportRow {
+    const char* type;
+    std::string_view name;
+    int quantity;
+    Money price;
+    int detail;
+    const char* detailUnit;
+
+    Money value() const { return price * quantity; }
+};
+
+// Report query: which items to include, their order, which page and columns to show, and the
+// output format. Parsed from text such as
+//   type=Electronic quantity<10 name~lap sort=-value columns=name,quantity,value page=2 size=50 format=csv
+// Conditions compare a column with =, !=, <, <=, >, >= or ~ (name or type contains the text);
+// "sort=-column" sorts in descending order.
+struct ReportQuery {
+    enum Column { Type, Name, Quantity, Price, Value, Detail };
+    enum Format { Table, Csv, Json };
+
+    struct Condition {
+        Column column;
+        std::string op;
+        std::string text;        // Type, Name
+        std::int64_t number = 0; // Quantity, Detail; cents for Price, Value
+    };
+
+    std::vector<Column> columns{Type, Name, Quantity, Price, Detail};
+    std::vector<Condition> conditions;
+    bool sorted = false;
+    Column sortBy = Name;
+    bool descending = false;
+    std::size_t page = 1;     // First page is 1
+    std::size_t pageSize = 0; // 0 shows every row
+    Format format = Table;
+
+    // Function to name a column as in queries and report headers
+    static const char* columnName(Column column) {
+        static const char* const names[] = {"type", "name", "quantity", "price", "value", "detail"};
+        return names[column];
+    }
+
+    // Function to look up a column by name; throws std::invalid_argument if it does not exist
+    static Column parseColumn(const std::string& name) {
+        for (int c = Type; c <= Detail; ++c) {
+            if (name == columnName(static_cast<Column>(c))) return static_cast<Column>(c);
+        }
+        throw std::invalid_argument("Unknown column: " + name);
+    }
+
+    // Function to parse a query; throws std::invalid_argument on errors
+    static ReportQuery parse(const std::string& text) {
+        ReportQuery query;
+        std::istringstream in(text);
+        std::string term;
+        while (in >> term) {
+            std::size_t at = term.find_first_of("=!<>~");
+            if (at == 0 || at == std::string::npos) throw std::invalid_argument("Invalid query term: " + term);
+            std::string key = term.substr(0, at);
+            std::size_t valueAt = at + (term.compare(at, 2, "!=") == 0 || term.compare(at, 2, "<=") == 0 ||
+                                                term.compare(at, 2, ">=") == 0 ? 2 : 1);
+            std::string op = term.substr(at, valueAt - at), value = term.substr(valueAt);
+            if (op == "=" && key == "sort") {
+                query.sorted = true;
+                query.descending = !value.empty() && value[0] == '-';
+                query.sortBy = parseColumn(query.descending ? value.substr(1) : value);
+            } else if (op == "=" && key == "columns") {
+                query.columns.clear();
+                std::istringstream names(value);
+                for (std::string name; std::getline(names, name, ',');) query.columns.push_back(parseColumn(name));
+                if (query.columns.empty()) throw std::invalid_argument("No columns selected.");
+            } else if (op == "=" && key == "page") {
+                query.page = std::stoul(value);
+                if (query.page == 0) throw std::invalid_argument("Pages start at 1.");
+            } else if (op == "=" && key == "size") {
+                query.pageSize = std::stoul(value);
+            } else if (op == "=" && key == "format") {
+                if (value == "table") query.format = Table;
+                else if (value == "csv") query.format = Csv;
+                else if (value == "json") query.format = Json;
+                else throw std::invalid_argument("Unknown format: " + value);
+            } else {
+                Condition condition{parseColumn(key), op, value};
+                bool textual = condition.column == Type || condition.column == Name;
+                if (op == "~" && !textual) throw std::invalid_argument("~ only applies to type and name.");
+                if (!textual) {
+                    condition.number = condition.column == Price || condition.column == Value
+                                           ? Money::parse(value).toCents() : std::stoll(value);
+                }
+                query.conditions.push_back(condition);
+            }
+        }
+        return query;
+    }
+
+    // Helper function to compare a row with a value: negative, zero or positive
+    static int compareText(std::string_view a, const std::string& b) { return a.compare(b); }
+
+    static std::int64_t number(const ReportRow& row, Column column) {
+        switch (column) {
+            case Quantity: return row.quantity;
+            case Price: return row.price.toCents();
+            case Value: return row.value().toCents();
+            default: return row.detail;
+        }
+    }
+
+    // Function to check whether a row meets every condition
+    bool matches(const ReportRow& row) const {
+        for (const auto& c : conditions) {
+            int order;
+            if (c.column == Type || c.column == Name) {
+                std::string_view field = c.column == Type ? std::string_view(row.type) : row.name;
+                if (c.op == "~") {
+                    if (field.find(c.text) == std::string_view::npos) return false;
+                    continue;
+                }
+                order = compareText(field, c.text);
+            } else {
+                std::int64_t field = number(row, c.column);
+                order = field < c.number ? -1 : field > c.number ? 1 : 0;
+            }
+            bool pass = c.op == "=" ? order == 0 : c.op == "!=" ? order != 0 : c.op == "<" ? order < 0
+                      : c.op == "<=" ? order <= 0 : c.op == ">" ? order > 0 : order >= 0;
+            if (!pass) return false;
+        }
+        return true;
+    }
+
+    // Function to order two rows by the sort column (then by name, so the order is total)
+    bool before(const ReportRow& a, const ReportRow& b) const {
+        int order = 0;
+        if (sortBy == Type) order = std::strcmp(a.type, b.type);
+        else if (sortBy != Name) {
+            std::int64_t x = number(a, sortBy), y = number(b, sortBy);
+            order = x < y ? -1 : x > y ? 1 : 0;
+        }
+        if (order == 0) order = a.name.compare(b.name);
+        return descending ? order > 0 : order < 0;
+    }
+};
+
+// Streaming report writer: formats rows straight into a large buffer, numbers with
+// std::to_chars, and hands the buffer to the output stream only when it is full
+class ReportWriter {
+    static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+
+    std::ostream& out;
+    const ReportQuery& query;
+    std::vector<char> buffer;
+    std::size_t used = 0;
+    std::size_t rows = 0;
+
+    // Helper function to make room for n more bytes
+    char* reserve(std::size_t n) {
+        if (used + n > buffer.size()) flush();
+        if (n > buffer.size()) buffer.resize(n);
+        return buffer.data() + used;
+    }
+
+    void put(std::string_view text) {
+        std::memcpy(reserve(text.size()), text.data(), text.size());
+        used += text.size();
+    }
+
+    void put(char c) {
+        *reserve(1) = c;
+        ++used;
+    }
+
+    void putNumber(std::int64_t value) {
+        char* at = reserve(24);
+        used = std::to_chars(at, at + 24, value).ptr - buffer.data();
+    }
+
+    void putMoney(Money amount) {
+        std::int64_t cents = amount.toCents();
+        std::uint64_t magnitude = cents < 0 ? 0 - static_cast<std::uint64_t>(cents) : static_cast<std::uint64_t>(cents);
+        char* at = reserve(24);
+        if (cents < 0) *at++ = '-';
+        at = std::to_chars(at, at + 22, magnitude / 100).ptr;
+        *at++ = '.';
+        *at++ = static_cast<char>('0' + magnitude % 100 / 10);
+        *at++ = static_cast<char>('0' + magnitude % 10);
+        used = at - buffer.data();
+    }
+
+    // Helper function to write text as a CSV field (quoted if needed) or a JSON string
+    void putText(std::string_view text) {
+        if (query.format == ReportQuery::Csv) {
+            if (text.find_first_of(",\"\n\r") == std::string_view::npos) return put(text);
+            put('"');
+            for (char c : text) {
+                if (c == '"') put('"');
+                put(c);
+            }
+            return put('"');
+        }
+        if (query.format == ReportQuery::Json) {
+            put('"');
+            bool plain = std::none_of(text.begin(), text.end(), [](char c) {
+                return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+            });
+            if (plain) {
+                put(text);
+                return put('"');
+            }
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    put('\\');
+                    put(c);
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    static const char hex[] = "0123456789abcdef";
+                    put("\\u00");
+                    put(hex[c >> 4]);
+                    put(hex[c & 15]);
+                } else {
+                    put(c);
+                }
+            }
+            return put('"');
+        }
+        put(text);
+    }
+
+public:
+    ReportWriter(std::ostream& output, const ReportQuery& q) : out(output), query(q), buffer(BUFFER_SIZE) {}
+    ~ReportWriter() { flush(); }
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    // Function to write the header line (table and CSV) or the opening bracket (JSON)
+    void begin() {
+        if (query.format == ReportQuery::Json) return put('[');
+        for (std::size_t i = 0; i < query.columns.size(); ++i) {
+            if (i) put(query.format == ReportQuery::Csv ? ',' : '\t');
+            put(ReportQuery::columnName(query.columns[i]));
+        }
+        put('\n');
+    }
+
+    // Function to write one row with the selected columns
+    void row(const ReportRow& r) {
+        bool json = query.format == ReportQuery::Json;
+        if (json) put(rows ? ",\n{" : "\n{");
+        for (std::size_t i = 0; i < query.columns.size(); ++i) {
+            ReportQuery::Column column = query.columns[i];
+            if (json) {
+                if (i) put(',');
+                put('"');
+                put(ReportQuery::columnName(column));
+                put("\":");
+            } else if (i) {
+                put(query.format == ReportQuery::Csv ? ',' : '\t');
+            }
+            switch (column) {
+                case ReportQuery::Type: putText(r.type); break;
+                case ReportQuery::Name: putText(r.name); break;
+                case ReportQuery::Quantity: putNumber(r.quantity); break;
+                case ReportQuery::Price: putMoney(r.price); break;
+                case ReportQuery::Value: putMoney(r.value()); break;
+                case ReportQuery::Detail:
+                    putNumber(r.detail);
+                    if (query.format == ReportQuery::Table) {
+                        put(' ');
+                        put(r.detailUnit);
+                    }
+                    break;
+            }
+        }
+        put(json ? '}' : '\n');
+        ++rows;
+    }
+
+    // Function to close the report; the table format ends with the range of rows shown
+    void end(std::size_t first, std::size_t matched) {
+        if (query.format == ReportQuery::Json) {
+            put(rows ? "\n]\n" : "]\n");
+        } else if (query.format == ReportQuery::Table) {
+            char line[96];
+            int length = rows ? std::snprintf(line, sizeof(line), "Rows %zu-%zu of %zu\n", first + 1, first + rows, matched)
+                              : std::snprintf(line, sizeof(line), "No rows (%zu matching)\n", matched);
+            put(std::string_view(line, length));
+        }
+        flush();
+    }
+
+    // Function to hand the buffered output to the stream
+    void flush() {
+        out.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+};
+
+// Function to render a report of the items in store that match query. Rows are streamed straight
+// from the store when no sort is requested; otherwise the matching rows are collected and only
+// the requested page is sorted into place. Returns the number of rows written.
+std::size_t renderReport(const Inventory& store, const ReportQuery& query, std::ostream& out) {
+    auto rowOf = [](const auto& item) {
+        using Category = std::decay_t<decltype(item)>;
+        return ReportRow{Category::getType(), item.name, item.quantity, item.price, item.getDetail(), Category::DETAIL_UNIT};
+    };
+    std::size_t first = (query.page - 1) * query.pageSize;
+    std::size_t last = query.pageSize ? first + query.pageSize : SIZE_MAX;
+    std::size_t matched = 0, written = 0;
+    ReportWriter writer(out, query);
+    writer.begin();
+    if (!query.sorted) {
+        store.forEach([&](const auto& item) {
+            ReportRow row = rowOf(item);
+            if (!query.matches(row)) return;
+            if (matched >= first && matched < last) {
+                writer.row(row);
+                ++written;
+            }
+            ++matched;
+        });
+    } else {
+        std::deque<std::string> names; // Stable copies: cold items are decoded into temporaries
+        std::vector<ReportRow> rows;
+        store.forEach([&](const auto& item) {
+            ReportRow row = rowOf(item);
+            if (!query.matches(row)) return;
+            names.push_back(item.name);
+            row.name = names.back();
+            rows.push_back(row);
+        });
+        matched = rows.size();
+
+        // Sort small (key, row) pairs rather than the rows; only equal keys need the full comparison
+        struct Keyed {
+            std::int64_t key;
+            std::size_t row;
+        };
+        bool numeric = query.sortBy != ReportQuery::Type && query.sortBy != ReportQuery::Name;
+        std::vector<Keyed> order(rows.size());
+        for (std::size_t i = 0; i < rows.size(); ++i) order[i] = Keyed{numeric ? ReportQuery::number(rows[i], query.sortBy) : 0, i};
+        auto before = [&](const Keyed& a, const Keyed& b) {
+            if (a.key != b.key) return query.descending ? a.key > b.key : a.key < b.key;
+            return query.before(rows[a.row], rows[b.row]);
+        };
+        std::size_t end = std::min(last, rows.size());
+        if (first < end) {
+            if (first > 0) std::nth_element(order.begin(), order.begin() + first, order.end(), before);
+            if (end == order.size()) std::sort(order.begin() + first, order.end(), before);
+            else std::partial_sort(order.begin() + first, order.begin() + end, order.end(), before);
+            for (std::size_t i = first; i < end; ++i) writer.row(rows[order[i].row]);
+            written = end - first;
+        }
+    }
+    writer.end(first, matched);
+    return written;
+}
+
+// Transaction class to track changes in inventory
+class Transaction {
+public:
+    std::string name, type; // name of the item and the type of transaction (added/removed)
+    
+    // Constructor to initialize a transaction
+    Transaction(std::string n, std::string t) : name(n), type(t) {}
+};
+
+// A customer order: a name and the quantity wanted of each item
+struct Order {
+    std::string name;
+    std::vector<std::pair<std::string, int>> lines; // (item name, quantity)
+
+    // Function to describe the order, e.g. "Order 7: Laptop x 1, Milk x 2"
+    std::string toString() const {
+        std::string text = name;
+        for (std::size_t i = 0; i < lines.size(); ++i)
+            text += (i ? ", " : ": ") + lines[i].first + " x " + std::to_string(lines[i].second);
+        return text;
+    }
+};
+
+// Queue for order management, where orders are processed in a FIFO manner
+class OrderQueue {
+    std::deque<Order> orders; // Pending orders, oldest first
+
+public:
+    // Function to add an order to the queue
+    void addOrder(const Order& order) {
+        orders.push_back(order);
+        std::cout << "Order added: " << order.toString() << "\n";
+    }
+
+    // Function to take every pending order off the queue for processing, oldest first
+    std::vector<Order> takeAll() {
+        std::vector<Order> taken(std::make_move_iterator(orders.begin()), std::make_move_iterator(orders.end()));
+        orders.clear();
+        return taken;
+    }
+
+    // Function to display all pending orders
+    void displayOrders() const {
+        if (orders.empty()) {
+            std::cout << "No pending orders.\n";
+            return;
+        }
+        std::cout << "Pending orders:\n";
+        for (const auto& order : orders) std::cout << order.toString() << "\n";
+    }
+
+    // Function to read the pending orders, oldest first
+    const std::deque<Order>& pending() const { return orders; }
+};
+
+// Location of a storage bin: aisle, shelf along the aisle, and bin (level) on the shelf. Written
+// as "A3-S12-B2".
+struct BinLocation {
+    int aisle = 0;
+    int shelf = 0;
+    int bin = 0;
+
+    // Function to parse "A<aisle>-S<shelf>-B<bin>"; throws std::invalid_argument otherwise
+    static BinLocation parse(const std::string& text) {
+        BinLocation location;
+        char a, s, b, dash1, dash2;
+        std::istringstream in(text);
+        if (!(in >> a >> location.aisle >> dash1 >> s >> location.shelf >> dash2 >> b >> location.bin) ||
+            std::toupper(a) != 'A' || std::toupper(s) != 'S' || std::toupper(b) != 'B' || dash1 != '-' ||
+            dash2 != '-' || location.aisle < 0 || location.shelf < 0 || location.bin < 0 || in.peek() != EOF)
+            throw std::invalid_argument("Invalid bin location (expected e.g. A3-S12-B2): " + text);
+        return location;
+    }
+
+    std::string toString() const {
+        return "A" + std::to_string(aisle) + "-S" + std::to_string(shelf) + "-B" + std::to_string(bin);
+    }
+
+    bool operator==(const BinLocation& other) const {
+        return aisle == other.aisle && shelf == other.shelf && bin == other.bin;
+    }
+    bool operator<(const BinLocation& other) const {
+        return std::tie(aisle, shelf, bin) < std::tie(other.aisle, other.shelf, other.bin);
+    }
+};
+
+// A quantity of one item received together (a lot) and stored in one bin
+struct Lot {
+    std::string id;
+    BinLocation location;
+    int quantity;
+};
+
+// Warehouse floor plan for routing: parallel aisles joined by cross aisles at the front and the
+// back, with the depot (where pickers start and finish) at the front of aisle 0. Bins on the
+// same shelf share a spot on the floor.
+struct WarehouseLayout {
+    struct Point {
+        double x, y;
+    };
+
+    double aislePitch = 3.0; // Meters between aisle centers
+    double shelfWidth = 1.0; // Meters of aisle per shelf
+    int shelves = 50;        // Shelves per aisle, which sets the aisle length
+
+    double aisleLength() const { return shelves * shelfWidth; }
+
+    Point depot() const { return Point{0, 0}; }
+
+    Point point(const BinLocation& location) const {
+        return Point{location.aisle * aislePitch, (location.shelf + 0.5) * shelfWidth};
+    }
+
+    // Function to compute the walking distance between two points: along the aisle if they share
+    // one, otherwise out through whichever cross aisle (front or back) is shorter
+    double distance(Point a, Point b) const {
+        if (a.x == b.x) return std::fabs(a.y - b.y);
+        double front = a.y + b.y, back = 2 * aisleLength() - a.y - b.y;
+        return std::fabs(a.x - b.x) + std::min(front, back);
+    }
+};
+
+// Pick-path planner. A route visits every stop once, starting and ending at the depot, and is
+// given as the order of stop indices. Two construction heuristics are available, the classic
+// S-shape (walk through every aisle with a pick, alternating direction) and nearest neighbor;
+// 2-opt then removes crossings, and plan() keeps the shorter result.
+class PickRouter {
+    const WarehouseLayout& layout;
+    std::vector<WarehouseLayout::Point> points; // Stops; the depot is handled separately
+
+    double between(std::size_t from, std::size_t to) const { return layout.distance(points[from], points[to]); }
+    double fromDepot(std::size_t stop) const { return layout.distance(layout.depot(), points[stop]); }
+
+public:
+    PickRouter(const WarehouseLayout& warehouse, const std::vector<BinLocation>& stops) : layout(warehouse) {
+        points.reserve(stops.size());
+        for (const auto& stop : stops) points.push_back(layout.point(stop));
+    }
+
+    // Function to compute the length of a route, including the walk from and back to the depot
+    double length(const std::vector<std::size_t>& route) const {
+        if (route.empty()) return 0;
+        double total = fromDepot(route.front()) + fromDepot(route.back());
+        for (std::size_t i = 1; i < route.size(); ++i) total += between(route[i - 1], route[i]);
+        return total;
+    }
+
+    // Function to build the S-shape route: aisles in order, up one and down the next
+    std::vector<std::size_t> sShape() const {
+        std::vector<std::size_t> route(points.size());
+        for (std::size_t i = 0; i < route.size(); ++i) route[i] = i;
+        std::sort(route.begin(), route.end(), [&](std::size_t a, std::size_t b) {
+            return points[a].x != points[b].x ? points[a].x < points[b].x : points[a].y < points[b].y;
+        });
+        bool up = true;
+        for (std::size_t start = 0; start < route.size();) {
+            std::size_t end = start;
+            while (end < route.size() && points[route[end]].x == points[route[start]].x) ++end;
+            if (!up) std::reverse(route.begin() + start, route.begin() + end);
+            up = !up;
+            start = end;
+        }
+        return route;
+    }
+
+    // Function to build a route by always walking to the closest unvisited stop
+    std::vector<std::size_t> nearestNeighbor() const {
+        std::vector<std::size_t> route;
+        route.reserve(points.size());
+        std::vector<bool> visited(points.size());
+        for (std::size_t step = 0; step < points.size(); ++step) {
+            std::size_t best = points.size();
+            double bestDistance = 0;
+            for (std::size_t i = 0; i < points.size(); ++i) {
+                if (visited[i]) continue;
+                double d = route.empty() ? fromDepot(i) : between(route.back(), i);
+                if (best == points.size() || d < bestDistance) {
+                    best = i;
+                    bestDistance = d;
+                }
+            }
+            visited[best] = true;
+            route.push_back(best);
+        }
+        return route;
+    }
+
+    // Function to improve a route with 2-opt: reverse any stretch of stops whose reversal makes
+    // the route shorter, until no reversal helps or maxPasses passes were made
+    void twoOpt(std::vector<std::size_t>& route, int maxPasses = 50) const {
+        std::size_t n = route.size();
+        // Distance between route positions i and j, where position -1 and n are the depot
+        auto at = [&](std::ptrdiff_t i, std::ptrdiff_t j) {
+            bool iDepot = i < 0 || i >= static_cast<std::ptrdiff_t>(n), jDepot = j < 0 || j >= static_cast<std::ptrdiff_t>(n);
+            if (iDepot && jDepot) return 0.0;
+            if (iDepot) return fromDepot(route[j]);
+            if (jDepot) return fromDepot(route[i]);
+            return between(route[i], route[j]);
+        };
+        for (int pass = 0; pass < maxPasses; ++pass) {
+            bool improved = false;
+            for (std::ptrdiff_t i = 0; i + 1 < static_cast<std::ptrdiff_t>(n); ++i) {
+                for (std::ptrdiff_t j = i + 1; j < static_cast<std::ptrdiff_t>(n); ++j) {
+                    // Replace edges (i-1, i) and (j, j+1) with (i-1, j) and (i, j+1)
+                    double delta = at(i - 1, j) + at(i, j + 1) - at(i - 1, i) - at(j, j + 1);
+                    if (delta < -1e-9) {
+                        std::reverse(route.begin() + i, route.begin() + j + 1);
+                        improved = true;
+                    }
+                }
+            }
+            if (!improved) break;
+        }
+    }
+
+    // Function to plan a short route: both heuristics followed by 2-opt, keeping the shorter
+    std::vector<std::size_t> plan() const {
+        std::vector<std::size_t> shape = sShape(), nearest = nearestNeighbor();
+        twoOpt(shape);
+        twoOpt(nearest);
+        return length(shape) <= length(nearest) ? shape : nearest;
+    }
+};
+
+// Asynchronous file I/O for snapshots, log appends and bulk loads. On Linux it uses io_uring:
+// requests queued with enqueue*() are pushed to the submission ring together by submit(), small
+// writes go through pre-registered buffers, and a reaper thread runs each completion callback.
+// Elsewhere, or if io_uring is unavailable, a small thread pool performs the same requests with
+// pwrite/pread/fsync. Callbacks receive the byte count (or 0 for sync) or -errno, on an I/O thread.
+// Submitting never blocks: beyond MAX_IN_FLIGHT, requests wait in a backlog that completions drain.
+class AsyncFileIO {
+public:
+    using Callback = std::function<void(long result)>;
+
+    static constexpr std::size_t FIXED_BUFFER_SIZE = 256 * 1024; // Size of each registered buffer
+    static constexpr unsigned FIXED_BUFFERS = 8;
+    static constexpr unsigned MAX_IN_FLIGHT = 128;
+
+private:
+    struct Request {
+        enum Op { Write, Read, Sync } op;
+        int fd;
+        std::string data;      // Write: bytes to write
+        char* into = nullptr;  // Read: destination
+        std::size_t length = 0;
+        off_t offset = 0;
+        Callback done;
+        int buffer = -1;       // Registered buffer used by a write, if any
+        std::size_t written = 0; // Write: bytes already written by earlier short writes
+    };
+
+    std::mutex mtx;               // Guards the queues below, the in-flight count and the free buffers
+    std::condition_variable idle; // Signalled when the last outstanding request completes
+    std::vector<std::unique_ptr<Request>> pending; // Enqueued but not submitted yet
+    std::deque<std::unique_ptr<Request>> backlog;  // Submitted, waiting for an in-flight slot
+    unsigned inFlight = 0;
+    bool stopping = false;
+
+    // Thread pool fallback
+    std::deque<std::unique_ptr<Request>> queue;
+    std::condition_variable work;
+    std::vector<std::thread> workers;
+
+#ifdef IMS_HAVE_IO_URING
+    int ring = -1;
+    void* sqMap = nullptr;
+    void* cqMap = nullptr;
+    void* sqeMap = nullptr;
+    std::size_t sqMapSize = 0, cqMapSize = 0, sqeMapSize = 0;
+    unsigned *sqHead = nullptr, *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    std::vector<std::vector<char>> fixedBuffers;
+    std::vector<int> freeBuffers;
+    std::thread reaper;
+
+    // Helper function to set up the ring; returns false if io_uring cannot be used
+    bool setupRing() {
+        io_uring_params params{};
+        ring = static_cast<int>(::syscall(__NR_io_uring_setup, MAX_IN_FLIGHT, &params));
+        if (ring < 0) return false;
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqeMapSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqMap = ::mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+        cqMap = ::mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+        sqeMap = ::mmap(nullptr, sqeMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+        if (sqMap == MAP_FAILED || cqMap == MAP_FAILED || sqeMap == MAP_FAILED) {
+            closeRing();
+            return false;
+        }
+        char* sq = static_cast<char*>(sqMap);
+        char* cq = static_cast<char*>(cqMap);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Register the write buffers once so the kernel does not have to map them on every write
+        std::vector<iovec> iovecs(FIXED_BUFFERS);
+        fixedBuffers.assign(FIXED_BUFFERS, std::vector<char>(FIXED_BUFFER_SIZE));
+        for (unsigned i = 0; i < FIXED_BUFFERS; ++i) iovecs[i] = iovec{fixedBuffers[i].data(), FIXED_BUFFER_SIZE};
+        if (::syscall(__NR_io_uring_register, ring, IORING_REGISTER_BUFFERS, iovecs.data(), FIXED_BUFFERS) == 0) {
+            for (unsigned i = 0; i < FIXED_BUFFERS; ++i) freeBuffers.push_back(static_cast<int>(i));
+        } else {
+            fixedBuffers.clear(); // Plain writes still work, e.g. under a low RLIMIT_MEMLOCK
+        }
+        reaper = std::thread(&AsyncFileIO::reap, this);
+        return true;
+    }
+
+    void closeRing() {
+        if (sqMap && sqMap != MAP_FAILED) ::munmap(sqMap, sqMapSize);
+        if (cqMap && cqMap != MAP_FAILED) ::munmap(cqMap, cqMapSize);
+        if (sqeMap && sqeMap != MAP_FAILED) ::munmap(sqeMap, sqeMapSize);
+        ::close(ring);
+        ring = -1;
+    }
+
+    // Helper function to submit count entries already in the submission ring, or to wait for a
+    // completion when count is 0. io_uring_enter may consume fewer entries than asked or fail with
+    // EINTR/EAGAIN/EBUSY under load, so it is called again until every entry has been taken.
+    void enterRing(unsigned count) {
+        do {
+            long taken = ::syscall(__NR_io_uring_enter, ring, count, count ? 0 : 1, count ? 0 : IORING_ENTER_GETEVENTS,
+                                   nullptr, 0);
+            if (taken < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    if (count == 0) return; // The reaper checks the completion ring and waits again
+                    std::this_thread::yield();
+                    continue;
+                }
+                std::cerr << "io_uring_enter failed: " << std::strerror(errno) << "\n";
+                return;
+            }
+            count -= static_cast<unsigned>(taken);
+        } while (count > 0);
+    }
+
+    // Helper function to fill one submission queue entry (called with mtx held). A write that was
+    // cut short is pushed again for its remaining bytes.
+    void pushToRing(std::unique_ptr<Request> request) {
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.fd = request->fd;
+        sqe.off = static_cast<std::uint64_t>(request->offset) + request->written;
+        if (request->op == Request::Write) {
+            if (request->written == 0 && request->data.size() <= FIXED_BUFFER_SIZE && !freeBuffers.empty()) {
+                request->buffer = freeBuffers.back();
+                freeBuffers.pop_back();
+                std::memcpy(fixedBuffers[request->buffer].data(), request->data.data(), request->data.size());
+            }
+            if (request->buffer >= 0) {
+                sqe.opcode = IORING_OP_WRITE_FIXED;
+                sqe.addr = reinterpret_cast<std::uint64_t>(fixedBuffers[request->buffer].data() + request->written);
+                sqe.buf_index = static_cast<std::uint16_t>(request->buffer);
+            } else {
+                sqe.opcode = IORING_OP_WRITE;
+                sqe.addr = reinterpret_cast<std::uint64_t>(request->data.data() + request->written);
+            }
+            sqe.len = static_cast<std::uint32_t>(request->data.size() - request->written);
+        } else if (request->op == Request::Read) {
+            sqe.opcode = IORING_OP_READ;
+            sqe.addr = reinterpret_cast<std::uint64_t>(request->into);
+            sqe.len = static_cast<std::uint32_t>(request->length);
+        } else {
+            sqe.opcode = IORING_OP_FSYNC;
+        }
+        sqe.user_data = reinterpret_cast<std::uint64_t>(request.release());
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // Reaper thread: waits for completions and runs their callbacks
+    void reap() {
+        for (;;) {
+            enterRing(0);
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            bool quit = false;
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes[head & *cqMask];
+                std::unique_ptr<Request> request(reinterpret_cast<Request*>(cqe.user_data));
+                long result = cqe.res;
+                __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                if (!request) {
+                    quit = true; // Wake-up sent by the destructor
+                    continue;
+                }
+                if (request->op == Request::Write && result >= 0) {
+                    // Retry a short write for the rest, as the thread pool does; stop if nothing was written
+                    request->written += static_cast<std::size_t>(result);
+                    if (result > 0 && request->written < request->data.size()) {
+                        std::lock_guard<std::mutex> lock(mtx);
+                        pushToRing(std::move(request));
+                        enterRing(1);
+                        continue;
+                    }
+                    result = static_cast<long>(request->written);
+                }
+                finish(std::move(request), result);
+            }
+            if (quit) return;
+        }
+    }
+#endif
+
+    // Helper function to start backlogged requests while in-flight slots are free (called with mtx held)
+    void issue() {
+        unsigned batch = 0;
+        for (; !backlog.empty() && inFlight < MAX_IN_FLIGHT; ++batch, ++inFlight) {
+#ifdef IMS_HAVE_IO_URING
+            if (ring >= 0) pushToRing(std::move(backlog.front()));
+            else
+#endif
+                queue.push_back(std::move(backlog.front()));
+            backlog.pop_front();
+        }
+        if (batch == 0) return;
+#ifdef IMS_HAVE_IO_URING
+        if (ring >= 0) {
+            enterRing(batch); // One call for the whole batch unless the kernel takes it in parts
+            return;
+        }
+#endif
+        work.notify_all();
+    }
+
+    // Helper function to complete a request: run its callback, free its slot and start the next one
+    void finish(std::unique_ptr<Request> request, long result) {
+        if (request->done) request->done(result);
+        std::lock_guard<std::mutex> lock(mtx);
+#ifdef IMS_HAVE_IO_URING
+        if (request->buffer >= 0) freeBuffers.push_back(request->buffer);
+#endif
+        --inFlight;
+        issue();
+        if (inFlight == 0) idle.notify_all();
+    }
+
+    // Worker loop of the thread pool fallback
+    void serve() {
+        for (;;) {
+            std::unique_ptr<Request> request;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                work.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                request = std::move(queue.front());
+                queue.pop_front();
+            }
+            long result;
+            if (request->op == Request::Write) {
+                result = 0;
+                while (static_cast<std::size_t>(result) < request->data.size()) {
+                    ssize_t n = ::pwrite(request->fd, request->data.data() + result, request->data.size() - result,
+                                         request->offset + result);
+                    if (n <= 0) {
+                        result = n < 0 ? -errno : result;
+                        break;
+                    }
+                    result += n;
+                }
+            } else if (request->op == Request::Read) {
+                ssize_t n = ::pread(request->fd, request->into, request->length, request->offset);
+                result = n < 0 ? -errno : n;
+            } else {
+                result = ::fsync(request->fd) == 0 ? 0 : -errno;
+            }
+            finish(std::move(request), result);
+        }
+    }
+
+    void enqueue(std::unique_ptr<Request> request) {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.push_back(std::move(request));
+    }
+
+public:
+    // Constructor; pass useIoUring = false to force the thread pool
+    explicit AsyncFileIO(bool useIoUring = true, unsigned threads = 2) {
+#ifdef IMS_HAVE_IO_URING
+        if (useIoUring && setupRing()) return;
+#else
+        (void)useIoUring;
+#endif
+        for (unsigned i = 0; i < std::max(1u, threads); ++i) workers.emplace_back(&AsyncFileIO::serve, this);
+    }
+
+    // Destructor: submits anything still queued, waits for every request, then stops the I/O threads
+    ~AsyncFileIO() {
+        submit();
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            idle.wait(lock, [this] { return inFlight == 0 && backlog.empty(); });
+            stopping = true;
+        }
+#ifdef IMS_HAVE_IO_URING
+        if (ring >= 0) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                unsigned tail = *sqTail;
+                unsigned index = tail & *sqMask;
+                std::memset(&sqes[index], 0, sizeof(io_uring_sqe));
+                sqes[index].opcode = IORING_OP_NOP; // user_data 0 tells the reaper to stop
+                sqArray[index] = index;
+                __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+                enterRing(1);
+            }
+            reaper.join();
+            closeRing();
+            return;
+        }
+#endif
+        work.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    AsyncFileIO(const AsyncFileIO&) = delete;
+    AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+    // Function to name the backend in use
+    const char* backend() const {
+#ifdef IMS_HAVE_IO_URING
+        if (ring >= 0) return "io_uring";
+#endif
+        return "thread pool";
+    }
+
+    // Functions to queue requests; nothing is issued until submit()
+    void enqueueWrite(int fd, std::string data, off_t offset, Callback done) {
+        auto request = std::make_unique<Request>();
+        request->op = Request::Write;
+        request->fd = fd;
+        request->data = std::move(data);
+        request->offset = offset;
+        request->done = std::move(done);
+        enqueue(std::move(request));
+    }
+
+    void enqueueRead(int fd, char* into, std::size_t length, off_t offset, Callback done) {
+        auto request = std::make_unique<Request>();
+        request->op = Request::Read;
+        request->fd = fd;
+        request->into = into;
+        request->length = length;
+        request->offset = offset;
+        request->done = std::move(done);
+        enqueue(std::move(request));
+    }
+
+    void enqueueSync(int fd, Callback done) {
+        auto request = std::make_unique<Request>();
+        request->op = Request::Sync;
+        request->fd = fd;
+        request->done = std::move(done);
+        enqueue(std::move(request));
+    }
+
+    // Function to issue every queued request, with one system call per batch of free slots
+    void submit() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& request : pending) backlog.push_back(std::move(request));
+        pending.clear();
+        issue();
+    }
+
+    // Functions to queue requests whose result is collected through a future instead of a callback
+    std::future<long> enqueueWrite(int fd, std::string data, off_t offset) {
+        auto promise = std::make_shared<std::promise<long>>();
+        enqueueWrite(fd, std::move(data), offset, [promise](long result) { promise->set_value(result); });
+        return promise->get_future();
+    }
+
+    std::future<long> enqueueRead(int fd, char* into, std::size_t length, off_t offset) {
+        auto promise = std::make_shared<std::promise<long>>();
+        enqueueRead(fd, into, length, offset, [promise](long result) { promise->set_value(result); });
+        return promise->get_future();
+    }
+
+    std::future<long> enqueueSync(int fd) {
+        auto promise = std::make_shared<std::promise<long>>();
+        enqueueSync(fd, [promise](long result) { promise->set_value(result); });
+        return promise->get_future();
+    }
+};
+
+// Background checkpointer that keeps an on-disk copy of the inventory without blocking the menu.
+// Every change is appended to a replay log, which is fsynced before the change is acknowledged,
+// and its record is marked dirty; a worker thread later writes only the dirty records into
+// fixed-width slots of the checkpoint file, fsyncs it and trims the log, so a checkpoint costs
+// O(changes) rather than O(inventory). Slots are rewritten in place: the rotated log is only
+// removed after the slot fsync, so a slot torn by a crash is rebuilt from it on the next start.
+class Checkpointer {
+public:
+    static constexpr std::size_t RECORD_SIZE = 128; // Width of one checkpoint slot, including the '\n'
+
+private:
+    std::string dataPath, logPath; // Checkpoint file and replay log
+    std::size_t maxDirty;          // Size policy: checkpoint once this many records are dirty
+    std::chrono::seconds interval; // Time policy: checkpoint at least this often while dirty
+
+    AsyncFileIO& files;          // Performs log appends and checkpoint writes
+
+    // Open replay log file and the appends still in flight to it
+    struct LogFile {
+        int fd = -1;
+        off_t end = 0;          // Offset of the next append
+        std::size_t writes = 0; // Appends queued but not yet synced (guarded by logMtx)
+    };
+
+    std::mutex mtx;              // Guards the current log, the dirty set and the stop flag
+    std::condition_variable cv;  // Wakes the worker when the size policy triggers or on shutdown
+    std::shared_ptr<LogFile> log; // Replay log receiving appends
+    std::unordered_map<std::string, std::string> dirty; // name -> latest record ("" means removed)
+    bool stopping = false;
+
+    std::mutex logMtx;               // Guards LogFile::writes
+    std::condition_variable logIdle; // Signalled when the last append to a log file completes
+
+    std::mutex ioMtx; // Serializes checkpoint runs (slot bookkeeping below is only touched under it)
+    std::unordered_map<std::string, std::size_t> slots; // name -> slot index in the checkpoint file
+    std::vector<std::size_t> freeSlots;                 // Slots released by removed items
+    std::size_t slotCount = 0;                          // Number of slots in the checkpoint file
+    std::vector<std::string> slotRecords;               // Live record per slot ("" for a free slot)
+    std::set<std::size_t> unsure; // Free slots a failed checkpoint may have written a record into
+
+    std::thread worker; // Started last so every member above is initialized
+
+    // Helper function to extract the item name (second field) from a record
+    static std::string recordName(const std::string& record) {
+        std::size_t first = record.find(',');
+        if (first == std::string::npos) return "";
+        std::size_t second = record.find(',', first + 1);
+        return record.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+    }
+
+    // Helper function to check that a put/remove log line is complete: "P," followed by a record
+    // that passes validRecord, or "R," followed by an item name
+    static bool validLine(const std::string& line) {
+        if (line.compare(0, 2, "P,") == 0) return validRecord(line.substr(2));
+        if (line.compare(0, 2, "R,") == 0) return line.size() > 2 && line.find(',', 2) == std::string::npos;
+        return false;
+    }
+
+    // Helper function to apply one put/remove log line to the dirty set
+    void replayLine(const std::string& line) {
+        if (line[0] == 'P') dirty[recordName(line.substr(2))] = line.substr(2);
+        else dirty[line.substr(2)] = "";
+    }
+
+    // Helper function to replay a log file into the dirty set. Only lines that end in '\n' and
+    // pass validLine are applied, and a batch ("B,<count>" followed by its lines) only if every
+    // one of its lines does, so a line cut short by a crash is never taken as a real change.
+    // A "B," header that does not parse is a torn tail: replay stops there.
+    void replayLog(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::vector<std::string> batch;
+        std::size_t expected = 0;
+        bool intact = true; // Every line of the current batch so far is valid
+        for (std::size_t at = 0, end; (end = text.find('\n', at)) != std::string::npos; at = end + 1) {
+            std::string line = text.substr(at, end - at);
+            if (line.compare(0, 2, "B,") == 0) {
+                const char* first = line.data() + 2;
+                const char* last = line.data() + line.size();
+                auto parsed = std::from_chars(first, last, expected);
+                if (parsed.ec != std::errc() || parsed.ptr != last || first == last) return;
+                batch.clear();
+                intact = true;
+            } else if (expected > 0) {
+                intact = intact && validLine(line);
+                batch.push_back(std::move(line));
+                if (batch.size() == expected) {
+                    if (intact) for (const auto& change : batch) replayLine(change);
+                    expected = 0;
+                }
+            } else if (validLine(line)) {
+                replayLine(line);
+            }
+        }
+    }
+
+    // Helper function to put a failed batch back, keeping any newer change to the same item
+    void requeue(const std::unordered_map<std::string, std::string>& batch) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const auto& change : batch) dirty.insert(change);
+    }
+
+    // Worker loop: checkpoint when enough records are dirty or the interval elapses
+    void run() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!stopping) {
+            cv.wait_for(lock, interval, [this] { return stopping || dirty.size() >= maxDirty; });
+            if (stopping || dirty.empty()) continue;
+            lock.unlock();
+            try {
+                checkpoint();
+            } catch (const std::exception& e) {
+                std::cerr << "Checkpoint failed: " << e.what() << "\n";
+            }
+            lock.lock();
+        }
+    }
+
+    // Helper function to open the replay log and find where appends continue
+    void openLog() {
+        auto file = std::make_shared<LogFile>();
+        file->fd = ::open(logPath.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (file->fd < 0) throw std::ios_base::failure("Error opening replay log.");
+        file->end = ::lseek(file->fd, 0, SEEK_END);
+        log = std::move(file);
+    }
+
+    // Helper function to queue an append to the replay log at its reserved offset, followed by an
+    // fsync of the log once the write completes (called with mtx held). The future is ready when
+    // the append is durable.
+    std::future<void> writeLog(std::string text) {
+        std::shared_ptr<LogFile> file = log;
+        off_t at = file->end;
+        file->end += static_cast<off_t>(text.size());
+        {
+            std::lock_guard<std::mutex> lock(logMtx);
+            ++file->writes;
+        }
+        auto durable = std::make_shared<std::promise<void>>();
+        std::future<void> done = durable->get_future();
+        auto complete = [this, file, durable](bool ok) {
+            if (!ok) std::cerr << "Replay log write failed.\n";
+            {
+                std::lock_guard<std::mutex> lock(logMtx);
+                if (--file->writes == 0) logIdle.notify_all();
+            }
+            durable->set_value();
+        };
+        long length = static_cast<long>(text.size());
+        files.enqueueWrite(file->fd, std::move(text), at, [this, file, length, complete](long result) {
+            if (result != length) return complete(false);
+            files.enqueueSync(file->fd, [complete](long synced) { complete(synced == 0); });
+            files.submit();
+        });
+        files.submit();
+        return done;
+    }
+
+    // Helper function to close a log file once every append queued to it has completed
+    void closeLog(const std::shared_ptr<LogFile>& file) {
+        std::unique_lock<std::mutex> lock(logMtx);
+        logIdle.wait(lock, [&] { return file->writes == 0; });
+        ::close(file->fd);
+    }
+
+    // Helper function to append one line to the replay log; returns once the line is durable
+    void append(const std::string& line, const std::string& name, const std::string& record) {
+        std::future<void> durable;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            durable = writeLog(line + "\n");
+            dirty[name] = record;
+            if (dirty.size() >= maxDirty) cv.notify_one();
+        }
+        durable.wait(); // Outside mtx, so other appends and the log rotation are not held up
+    }
+
+public:
+    // Constructor: rebuilds the slot map from an existing checkpoint, queues any changes left in
+    // the replay logs by a previous run, and starts the background worker
+    Checkpointer(AsyncFileIO& fileIO, const std::string& data = "inventory.ckpt", const std::string& logFile = "inventory.log",
+                 std::size_t maxDirtyRecords = 64, std::chrono::seconds every = std::chrono::seconds(5))
+        : dataPath(data), logPath(logFile), maxDirty(maxDirtyRecords), interval(every), files(fileIO) {
+        std::ifstream in(dataPath);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::size_t end = line.find_last_not_of(' ');
+            std::string record = end == std::string::npos ? "" : line.substr(0, end + 1);
+            if (!record.empty() && !validRecord(record)) {
+                record.clear(); // Torn by a crash during a checkpoint; the rotated log still has its change
+                unsure.insert(slotCount);
+            }
+            if (record.empty()) freeSlots.push_back(slotCount);
+            else slots[recordName(record)] = slotCount;
+            slotRecords.push_back(record);
+            ++slotCount;
+        }
+        replayLog(logPath + ".old"); // Left behind by a checkpoint that did not finish
+        replayLog(logPath);
+        openLog();
+        worker = std::thread(&Checkpointer::run, this);
+    }
+
+    // Destructor: stops the worker and writes a final checkpoint
+    ~Checkpointer() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_one();
+        worker.join();
+        try {
+            checkpoint();
+        } catch (const std::exception& e) {
+            std::cerr << "Checkpoint failed: " << e.what() << "\n";
+        }
+        closeLog(log);
+    }
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    // Function to check that a record has the five fields "Type,name,quantity,price,detail" with
+    // a known type, a non-empty name, whole-number quantity and detail, and a valid price
+    static bool validRecord(const std::string& record) {
+        std::string_view fields[5];
+        std::string_view rest(record);
+        for (int i = 0; i < 4; ++i) {
+            std::size_t comma = rest.find(',');
+            if (comma == std::string_view::npos) return false;
+            fields[i] = rest.substr(0, comma);
+            rest.remove_prefix(comma + 1);
+        }
+        fields[4] = rest;
+        auto whole = [](std::string_view field, bool allowNegative) {
+            int value = 0;
+            auto parsed = std::from_chars(field.data(), field.data() + field.size(), value);
+            return !field.empty() && parsed.ec == std::errc() && parsed.ptr == field.data() + field.size() &&
+                   (allowNegative || value >= 0);
+        };
+        if (!Inventory::withCategory(std::string(fields[0]), [](auto) {}) || fields[1].empty() ||
+            !whole(fields[2], false) || !whole(fields[4], true))
+            return false;
+        try {
+            Money::parse(std::string(fields[3]));
+        } catch (const std::invalid_argument&) {
+            return false;
+        }
+        return true;
+    }
+
+    // Function to write records to a new checkpoint file, one slot each in the given order, so a
+    // checkpointer opened on it recovers exactly these records in this order
+    static void writeCheckpoint(const std::string& path, const std::vector<std::string>& records) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        for (const auto& record : records) {
+            if (record.size() >= RECORD_SIZE) throw std::length_error("Item record too long for checkpoint.");
+            out << record << std::string(RECORD_SIZE - 1 - record.size(), ' ') << '\n';
+        }
+        out.close();
+        if (!out) throw std::ios_base::failure("Error writing checkpoint file " + path + ".");
+    }
+
+    // Function to log an added or changed item; record is "Type,name,quantity,price,detail"
+    void recordPut(const std::string& record) {
+        if (record.size() >= RECORD_SIZE) throw std::length_error("Item record too long for checkpoint.");
+        append("P," + record, recordName(record), record);
+    }
+
+    // Function to log a removed item
+    void recordRemove(const std::string& name) {
+        append("R," + name, name, "");
+    }
+
+    // Function to log several changes as one transaction record with a single write;
+    // each change is (name, record) where an empty record means the item was removed
+    void recordBatch(std::vector<std::pair<std::string, std::string>> changes) {
+        std::size_t size = 24;
+        for (const auto& change : changes) {
+            if (change.second.size() >= RECORD_SIZE) throw std::length_error("Item record too long for checkpoint.");
+            size += 3 + (change.second.empty() ? change.first.size() : change.second.size());
+        }
+        std::string text = "B," + std::to_string(changes.size()) + "\n";
+        text.reserve(size);
+        for (const auto& change : changes) {
+            text += change.second.empty() ? "R," : "P,";
+            text += change.second.empty() ? change.first : change.second;
+            text += '\n';
+        }
+        std::future<void> durable;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            durable = writeLog(std::move(text));
+            dirty.reserve(dirty.size() + changes.size());
+            for (auto& change : changes) dirty.insert_or_assign(std::move(change.first), std::move(change.second));
+            if (dirty.size() >= maxDirty) cv.notify_one();
+        }
+        durable.wait();
+    }
+
+    // Function to write all dirty records to their slots, fsync, and trim the replay log
+    void checkpoint() {
+        std::lock_guard<std::mutex> io(ioMtx);
+        std::unordered_map<std::string, std::string> batch;
+        std::shared_ptr<LogFile> rotated;
+        {
+            // Rotate the log: changes made from here on go to a fresh log and stay dirty
+            std::lock_guard<std::mutex> lock(mtx);
+            if (dirty.empty()) return;
+            batch.swap(dirty);
+            std::string old = logPath + ".old";
+            if (std::ifstream(old)) {
+                closeLog(log); // Left by a failed checkpoint: append this log once it is complete
+                std::ifstream in(logPath);
+                std::ofstream(old, std::ios::app) << in.rdbuf();
+                std::remove(logPath.c_str());
+            } else {
+                rotated = log; // Appends still in flight land in the renamed file
+                if (std::rename(logPath.c_str(), old.c_str()) != 0) std::remove(logPath.c_str());
+            }
+            openLog();
+        }
+        if (rotated) closeLog(rotated); // Wait without blocking new appends
+
+        int fd = ::open(dataPath.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (fd < 0) {
+            requeue(batch);
+            throw std::ios_base::failure("Error opening checkpoint file.");
+        }
+        // Assign slots on copies of the bookkeeping; it is committed only once the slots are synced,
+        // so a failed checkpoint can be retried from the same state
+        std::vector<std::size_t> free = freeSlots;
+        std::size_t count = slotCount;
+        std::vector<std::pair<const std::string*, std::size_t>> placed; // Item and its new slot (npos if removed)
+        std::vector<std::size_t> taken;                                 // Free or new slots given to items
+        std::map<std::size_t, const std::string*> written;              // Record per slot touched, in slot order
+        for (const auto& change : batch) {
+            const std::string& name = change.first;
+            const std::string& record = change.second;
+            auto found = slots.find(name);
+            std::size_t slot;
+            if (found != slots.end()) {
+                slot = found->second;
+                if (record.empty()) {
+                    placed.emplace_back(&name, std::string::npos);
+                    free.push_back(slot);
+                }
+            } else if (record.empty()) {
+                continue; // Added and removed between two checkpoints
+            } else {
+                if (!free.empty()) {
+                    slot = free.back();
+                    free.pop_back();
+                } else {
+                    slot = count++;
+                }
+                placed.emplace_back(&name, slot);
+                taken.push_back(slot);
+            }
+            written[slot] = &record;
+        }
+        static const std::string blank;
+        for (std::size_t slot : unsure) {
+            if (written.count(slot)) continue;
+            written[slot] = &blank; // Clear a record an earlier failed attempt may have left there
+            if (slot >= count) {
+                free.push_back(slot);
+                count = slot + 1;
+            }
+        }
+
+        // Write each run of adjacent slots with a single write, submitting all runs together
+        std::vector<std::pair<std::future<long>, std::size_t>> writes; // Result and expected length per run
+        for (auto it = written.begin(); it != written.end();) {
+            std::size_t first = it->first;
+            std::string run;
+            std::size_t next = first;
+            for (; it != written.end() && it->first == next; ++it, ++next) {
+                std::size_t at = run.size();
+                run += *it->second;
+                run.resize(at + RECORD_SIZE - 1, ' ');
+                run += '\n';
+            }
+            std::size_t length = run.size();
+            writes.emplace_back(files.enqueueWrite(fd, std::move(run), static_cast<off_t>(first * RECORD_SIZE)), length);
+        }
+        files.submit();
+        bool complete = true;
+        for (auto& write : writes) complete = write.first.get() == static_cast<long>(write.second) && complete;
+        bool synced = false;
+        if (complete) {
+            std::future<long> sync = files.enqueueSync(fd);
+            files.submit();
+            synced = sync.get() == 0;
+        }
+        ::close(fd);
+        if (!synced) {
+            unsure.insert(taken.begin(), taken.end());
+            requeue(batch);
+            throw std::ios_base::failure(complete ? "Error syncing checkpoint file." : "Error writing checkpoint file.");
+        }
+
+        // Commit the slot assignment now that it is durable
+        for (const auto& item : placed) {
+            if (item.second == std::string::npos) slots.erase(*item.first);
+            else slots[*item.first] = item.second;
+        }
+        freeSlots = std::move(free);
+        slotCount = count;
+        slotRecords.resize(count);
+        for (const auto& slot : written) slotRecords[slot.first] = *slot.second;
+        unsure.clear();
+        std::remove((logPath + ".old").c_str()); // Trim: the checkpoint now covers the rotated log
+    }
+
+    // Function to rebuild the list of live records from the checkpoint plus pending changes
+    std::vector<std::string> recover() {
+        std::lock_guard<std::mutex> io(ioMtx);
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<std::string> records;
+        for (const auto& record : slotRecords) {
+            if (!record.empty() && !dirty.count(recordName(record))) records.push_back(record);
+        }
+        for (const auto& change : dirty) {
+            if (!change.second.empty()) records.push_back(change.second);
+        }
+        return records;
+    }
+};
+
+// One change published to change-data-capture subscribers
+struct ChangeEvent {
+    enum Kind { ItemAdded, ItemRemoved, ItemUpdated, OrderAdded, OrderProcessed };
+
+    std::uint64_t sequence = 0; // Position in the change stream, starting at 1
+    Kind kind = ItemUpdated;
+    std::string name;           // Item name or order
+    int quantity = 0;           // Item quantity after the change
+    Money price;                // Item price after the change
+
+    // Function to get the text used for a kind in the change log
+    static const char* kindName(Kind kind) {
+        static const char* const names[] = {"ItemAdded", "ItemRemoved", "ItemUpdated", "OrderAdded", "OrderProcessed"};
+        return names[kind];
+    }
+
+    // Function to format the event as a change log line: sequence,kind,quantity,price,name
+    std::string toLine() const {
+        std::string line;
+        appendLine(line);
+        return line;
+    }
+
+    // Function to append the change log line to text
+    void appendLine(std::string& text) const {
+        char number[24];
+        text.append(number, std::to_chars(number, number + sizeof(number), sequence).ptr);
+        text += ',';
+        text += kindName(kind);
+        text += ',';
+        text.append(number, std::to_chars(number, number + sizeof(number), quantity).ptr);
+        text += ',';
+        price.appendTo(text);
+        text += ',';
+        text += name;
+    }
+
+    // Function to parse a change log line; returns false for torn or malformed lines
+    static bool parse(const std::string& line, ChangeEvent& event) {
+        std::istringstream in(line);
+        std::string sequence, kind, quantity, price;
+        if (!std::getline(in, sequence, ',') || !std::getline(in, kind, ',') || !std::getline(in, quantity, ',') ||
+            !std::getline(in, price, ',') || !std::getline(in, event.name))
+            return false;
+        for (int k = ItemAdded; k <= OrderProcessed; ++k) {
+            if (kind != kindName(static_cast<Kind>(k))) continue;
+            try {
+                event.sequence = std::stoull(sequence);
+                event.kind = static_cast<Kind>(k);
+                event.quantity = std::stoi(quantity);
+                event.price = Money::parse(price);
+            } catch (const std::exception&) {
+                return false;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Function to read complete events with a sequence >= from, starting at byte offset;
+    // returns the offset just past the last complete line so a tailing reader can continue
+    template <typename F>
+    static std::streamoff readLog(const std::string& path, std::uint64_t from, std::streamoff offset, F&& f) {
+        std::ifstream in(path);
+        if (!in) return offset;
+        in.seekg(offset);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (in.eof()) break; // Last line is still being written
+            offset = in.tellg();
+            ChangeEvent event;
+            if (parse(line, event) && event.sequence >= from) f(event);
+        }
+        return offset;
+    }
+};
+
+// A change-data-capture subscriber. Events arrive through a bounded single-producer/single-consumer
+// ring buffer; the writer never waits for a slow consumer. When the ring is full the subscription is
+// marked as overflowed, and the consumer catches up from the change log on its next poll.
+class Subscription {
+    std::vector<ChangeEvent> ring;        // Capacity is a power of two
+    std::atomic<std::size_t> head{0};     // Next slot to read (advanced by the consumer)
+    std::atomic<std::size_t> tail{0};     // Next slot to write (advanced by the writer)
+    std::atomic<bool> overflowed{false};  // Events were dropped from the ring
+    std::uint64_t lastSequence;           // Last event delivered to the consumer
+    std::string logPath;                  // Change log used to catch up after an overflow
+    std::streamoff logOffset = 0;         // Where the previous catch-up stopped reading the log
+
+public:
+    // Constructor; events after fromSequence - 1 are delivered, older ones are replayed from the log
+    Subscription(std::size_t capacity, std::uint64_t fromSequence, std::uint64_t nextSequence, std::string changeLog)
+        : lastSequence(fromSequence ? fromSequence - 1 : 0), logPath(std::move(changeLog)) {
+        std::size_t size = 1;
+        while (size < capacity) size <<= 1;
+        ring.resize(size);
+        if (fromSequence < nextSequence) overflowed = true; // Start by replaying the log
+    }
+
+    // Function called by the writer; drops the event and flags an overflow if the ring is full
+    void push(const ChangeEvent& event) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == ring.size()) {
+            overflowed.store(true, std::memory_order_release);
+            return;
+        }
+        ring[t & (ring.size() - 1)] = event;
+        tail.store(t + 1, std::memory_order_release);
+    }
+
+    // Function called by the consumer to take up to max events in sequence order
+    std::size_t poll(std::vector<ChangeEvent>& out, std::size_t max = 1024) {
+        std::size_t taken = 0;
+        if (overflowed.load(std::memory_order_acquire)) {
+            // Empty the ring and clear the flag before reading the log: every event the writer
+            // drops from now on is already in the log, and everything later lands in the ring
+            head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+            overflowed.store(false, std::memory_order_release);
+            logOffset = ChangeEvent::readLog(logPath, lastSequence + 1, logOffset, [&](const ChangeEvent& event) {
+                if (event.sequence != lastSequence + 1) return;
+                out.push_back(event);
+                lastSequence = event.sequence;
+                ++taken;
+            });
+        }
+        std::size_t h = head.load(std::memory_order_relaxed);
+        std::size_t t = tail.load(std::memory_order_acquire);
+        for (; h != t && taken < max; ++h) {
+            ChangeEvent& event = ring[h & (ring.size() - 1)];
+            if (event.sequence <= lastSequence) continue; // Already replayed from the log
+            lastSequence = event.sequence;
+            out.push_back(std::move(event));
+            ++taken;
+        }
+        head.store(h, std::memory_order_release);
+        return taken;
+    }
+
+    // Function to get the sequence of the last delivered event (to resume from later)
+    std::uint64_t position() const { return lastSequence; }
+};
+
+// Change-data-capture feed. Each change gets the next sequence number, is appended to the
+// change log (kept for consumers that resume later, including other processes) and is then
+// pushed to every subscriber's ring.
+class ChangeFeed {
+    std::string logPath;
+    std::ofstream log;
+    std::uint64_t nextSequence = 1;
+    std::mutex mtx; // Serializes publishers and guards the subscriber list
+    std::vector<std::shared_ptr<Subscription>> subscribers;
+
+public:
+    // Constructor; continues numbering after the last event in an existing change log
+    explicit ChangeFeed(const std::string& path = "changes.log") : logPath(path) {
+        std::ifstream in(logPath, std::ios::ate);
+        std::streamoff size = in ? static_cast<std::streamoff>(in.tellg()) : 0;
+        std::streamoff start = std::max<std::streamoff>(0, size - 4096); // Only the tail is needed
+        std::uint64_t last = 0;
+        ChangeEvent::readLog(logPath, 0, start, [&](const ChangeEvent& event) { last = event.sequence; });
+        nextSequence = last + 1;
+        log.open(logPath, std::ios::app);
+        if (!log) throw std::ios_base::failure("Error opening change log.");
+    }
+
+    // Function to register a consumer; pass fromSequence to resume after an earlier position
+    std::shared_ptr<Subscription> subscribe(std::size_t capacity = 1024, std::uint64_t fromSequence = 0) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto subscription = std::make_shared<Subscription>(capacity, fromSequence ? fromSequence : nextSequence,
+                                                           nextSequence, logPath);
+        subscribers.push_back(subscription);
+        return subscription;
+    }
+
+    // Function to remove a consumer
+    void unsubscribe(const std::shared_ptr<Subscription>& subscription) {
+        std::lock_guard<std::mutex> lock(mtx);
+        subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), subscription), subscribers.end());
+    }
+
+    // Function to publish a change; returns its sequence number
+    std::uint64_t publish(ChangeEvent::Kind kind, const std::string& name, int quantity = 0, Money price = Money()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        ChangeEvent event;
+        event.sequence = nextSequence++;
+        event.kind = kind;
+        event.name = name;
+        event.quantity = quantity;
+        event.price = price;
+        log << event.toLine() << "\n";
+        log.flush(); // The log must hold the event before any ring can drop it
+        for (const auto& subscriber : subscribers) subscriber->push(event);
+        return event.sequence;
+    }
+
+    // Function to publish several changes with a single write to the change log; numbers the
+    // events and returns the sequence number of the first
+    std::uint64_t publish(std::vector<ChangeEvent>& events) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::uint64_t first = nextSequence;
+        std::string text;
+        for (auto& event : events) {
+            event.sequence = nextSequence++;
+            event.appendLine(text);
+            text += '\n';
+        }
+        log << text;
+        log.flush(); // The log must hold the events before any ring can drop them
+        for (const auto& event : events) {
+            for (const auto& subscriber : subscribers) subscriber->push(event);
+        }
+        return first;
+    }
+};
+
+// An alert raised or cleared by a stock rule
+struct Alert {
+    enum Rule : std::uint8_t { MinQuantity, MaxQuantity, MinValue, MaxValue, Expiry, RULES };
+    enum State : std::uint8_t { Raised, Cleared, Withdrawn }; // Withdrawn: the rule or the item went away
+
+    std::uint64_t sequence = 0; // Order in which alerts happened, starting at 1
+    State state = Raised;
+    Rule rule = MinQuantity;
+    std::string item;
+    std::int64_t value = 0; // What the rule measured: quantity, value in cents or shelf life in days
+    std::int64_t limit = 0;
+
+    // Function to get the name used for a rule in menus and files
+    static const char* ruleName(Rule rule) {
+        static const char* const names[] = {"min-quantity", "max-quantity", "min-value", "max-value", "expiry"};
+        return names[rule];
+    }
+
+    // Function to parse a rule name; throws std::invalid_argument for unknown names
+    static Rule parseRule(const std::string& text) {
+        for (int r = MinQuantity; r < RULES; ++r) {
+            if (text == ruleName(static_cast<Rule>(r))) return static_cast<Rule>(r);
+        }
+        throw std::invalid_argument("Unknown rule: " + text);
+    }
+
+    // Function to format an amount the way a rule measures it (money for value rules)
+    static std::string formatAmount(Rule rule, std::int64_t amount) {
+        return rule == MinValue || rule == MaxValue ? Money::fromCents(amount).toString() : std::to_string(amount);
+    }
+
+    // Function to parse an amount the way a rule measures it
+    static std::int64_t parseAmount(Rule rule, const std::string& text) {
+        if (rule == MinValue || rule == MaxValue) return Money::parse(text).toCents();
+        std::int64_t amount = 0;
+        auto parsed = std::from_chars(text.data(), text.data() + text.size(), amount);
+        if (parsed.ec != std::errc() || parsed.ptr != text.data() + text.size())
+            throw std::invalid_argument("Invalid amount: " + text);
+        return amount;
+    }
+
+    // Function to describe the alert, e.g. "raised: Milk min-quantity 3 (limit 10)"
+    std::string toString() const {
+        static const char* const states[] = {"raised", "cleared", "withdrawn"};
+        std::string text = std::string(states[state]) + ": " + item + " " + ruleName(rule);
+        if (state != Withdrawn) text += " " + formatAmount(rule, value);
+        return text + " (limit " + formatAmount(rule, limit) + ")";
+    }
+};
+
+// An alert consumer. As with a change-feed subscription, alerts arrive through a bounded
+// single-producer/single-consumer ring buffer and the writer never waits for the consumer.
+// Alerts that find the ring full are counted as dropped; AlertEngine::forEachRule shows what is
+// firing now.
+class AlertSubscription {
+    std::vector<Alert> ring;             // Capacity is a power of two
+    std::atomic<std::size_t> head{0};    // Next slot to read (advanced by the consumer)
+    std::atomic<std::size_t> tail{0};    // Next slot to write (advanced by the writer)
+    std::atomic<std::uint64_t> dropped{0};
+
+public:
+    explicit AlertSubscription(std::size_t capacity) {
+        std::size_t size = 1;
+        while (size < capacity) size <<= 1;
+        ring.resize(size);
+    }
+
+    // Function called by the writer; drops the alert if the ring is full
+    void push(const Alert& alert) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == ring.size()) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring[t & (ring.size() - 1)] = alert;
+        tail.store(t + 1, std::memory_order_release);
+    }
+
+    // Function called by the consumer to take up to max alerts in order
+    std::size_t poll(std::vector<Alert>& out, std::size_t max = 1024) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        std::size_t t = tail.load(std::memory_order_acquire);
+        std::size_t taken = 0;
+        for (; h != t && taken < max; ++h, ++taken) out.push_back(std::move(ring[h & (ring.size() - 1)]));
+        head.store(h, std::memory_order_release);
+        return taken;
+    }
+
+    // Function to get how many alerts were dropped because the ring was full
+    std::uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+};
+
+// Stock alert rules, checked incrementally: the owner of the inventory calls check() with an
+// item's new state on every change, which costs one hash lookup plus a comparison per rule of that
+// item, however many rules there are in total. A rule raises an alert when its limit is crossed
+// and clears it only once the value is back past the limit by the rule's hysteresis band, so an
+// item hovering around a limit does not flood subscribers; a firing rule is not raised again.
+// Like the inventory it has one writer; only subscribe and unsubscribe may be called by others.
+class AlertEngine {
+    struct ItemRules {
+        std::int64_t limit[Alert::RULES];
+        std::int32_t band[Alert::RULES]; // Hysteresis
+        std::uint8_t active = 0;         // Bit per rule that is set
+        std::uint8_t firing = 0;         // Bit per rule whose alert is raised
+    };
+
+    std::unordered_map<std::string, ItemRules> rules;
+    std::size_t ruleCount = 0;
+    std::uint64_t nextSequence = 1;
+    std::mutex mtx; // Guards the subscriber list
+    std::vector<std::shared_ptr<AlertSubscription>> subscribers;
+
+    static bool breached(Alert::Rule rule, std::int64_t value, std::int64_t limit) {
+        switch (rule) {
+            case Alert::MinQuantity:
+            case Alert::MinValue: return value < limit;
+            case Alert::MaxQuantity:
+            case Alert::MaxValue: return value > limit;
+            default: return value <= limit; // Expiry: shelf life down to the window
+        }
+    }
+
+    static bool recovered(Alert::Rule rule, std::int64_t value, std::int64_t limit, std::int64_t band) {
+        switch (rule) {
+            case Alert::MinQuantity:
+            case Alert::MinValue: return value >= limit + band;
+            case Alert::MaxQuantity:
+            case Alert::MaxValue: return value <= limit - band;
+            default: return value > limit + band;
+        }
+    }
+
+    void emit(Alert::State state, Alert::Rule rule, const std::string& item, std::int64_t value, std::int64_t limit) {
+        Alert alert{nextSequence++, state, rule, item, value, limit};
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const auto& subscriber : subscribers) subscriber->push(alert);
+    }
+
+public:
+    // Function to register a consumer
+    std::shared_ptr<AlertSubscription> subscribe(std::size_t capacity = 1024) {
+        auto subscription = std::make_shared<AlertSubscription>(capacity);
+        std::lock_guard<std::mutex> lock(mtx);
+        subscribers.push_back(subscription);
+        return subscription;
+    }
+
+    // Function to remove a consumer
+    void unsubscribe(const std::shared_ptr<AlertSubscription>& subscription) {
+        std::lock_guard<std::mutex> lock(mtx);
+        subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), subscription), subscribers.end());
+    }
+
+    // Function to set (or replace) one of an item's rules; the item's next check applies it
+    void setRule(const std::string& item, Alert::Rule rule, std::int64_t limit, std::int32_t hysteresis = 0) {
+        if (hysteresis < 0) throw std::invalid_argument("Hysteresis must not be negative.");
+        ItemRules& set = rules[item];
+        std::uint8_t bit = static_cast<std::uint8_t>(1u << rule);
+        if (!(set.active & bit)) ++ruleCount;
+        set.active |= bit;
+        set.limit[rule] = limit;
+        set.band[rule] = hysteresis;
+    }
+
+    // Function to remove one of an item's rules, withdrawing its alert; false if it was not set
+    bool removeRule(const std::string& item, Alert::Rule rule) {
+        auto found = rules.find(item);
+        std::uint8_t bit = static_cast<std::uint8_t>(1u << rule);
+        if (found == rules.end() || !(found->second.active & bit)) return false;
+        if (found->second.firing & bit) emit(Alert::Withdrawn, rule, item, 0, found->second.limit[rule]);
+        --ruleCount;
+        if ((found->second.active &= static_cast<std::uint8_t>(~bit)) == 0) rules.erase(found);
+        else found->second.firing &= static_cast<std::uint8_t>(~bit);
+        return true;
+    }
+
+    // Function to check an item's rules against its new state; shelfDays is -1 for items that do
+    // not expire
+    void check(const std::string& item, int quantity, Money price, int shelfDays) {
+        if (rules.empty()) return;
+        auto found = rules.find(item);
+        if (found == rules.end()) return;
+        ItemRules& set = found->second;
+        std::int64_t value = (price * quantity).toCents();
+        const std::int64_t measured[Alert::RULES] = {quantity, quantity, value, value, shelfDays};
+        for (int r = 0; r < Alert::RULES; ++r) {
+            std::uint8_t bit = static_cast<std::uint8_t>(1u << r);
+            if (!(set.active & bit) || (r == Alert::Expiry && shelfDays < 0)) continue;
+            Alert::Rule rule = static_cast<Alert::Rule>(r);
+            if (!(set.firing & bit)) {
+                if (!breached(rule, measured[r], set.limit[r])) continue;
+                set.firing |= bit;
+                emit(Alert::Raised, rule, item, measured[r], set.limit[r]);
+            } else if (recovered(rule, measured[r], set.limit[r], set.band[r])) {
+                set.firing &= static_cast<std::uint8_t>(~bit);
+                emit(Alert::Cleared, rule, item, measured[r], set.limit[r]);
+            }
+        }
+    }
+
+    // Function to note that an item left the inventory: its alerts are withdrawn, its rules stay
+    void forget(const std::string& item) {
+        auto found = rules.find(item);
+        if (found == rules.end() || !found->second.firing) return;
+        for (int r = 0; r < Alert::RULES; ++r) {
+            if (found->second.firing & (1u << r))
+                emit(Alert::Withdrawn, static_cast<Alert::Rule>(r), item, 0, found->second.limit[r]);
+        }
+        found->second.firing = 0;
+    }
+
+    // Function to visit every rule as f(item, rule, limit, hysteresis, firing)
+    template <typename F>
+    void forEachRule(F&& f) const {
+        for (const auto& entry : rules) {
+            for (int r = 0; r < Alert::RULES; ++r) {
+                if (entry.second.active & (1u << r))
+                    f(entry.first, static_cast<Alert::Rule>(r), entry.second.limit[r], entry.second.band[r],
+                      (entry.second.firing & (1u << r)) != 0);
+            }
+        }
+    }
+
+    // Function to get the number of rules
+    std::size_t size() const { return ruleCount; }
+};
+
+// Time-limited stock holds, e.g. for cart checkouts. For every item the book keeps a copy of its
+// stock on hand (kept current by the owner of the inventory through setStock) and how much of it
+// is reserved; what is left is available. A reservation holds one or more lines until it is
+// confirmed, released or expires, and always as a whole. Items and reservations are spread over
+// shards with a mutex each, so threads holding different items rarely wait for one another; a
+// reservation locks the shards of its items in index order. A sweeper thread reclaims expired
+// holds through a hashed timer wheel per reservation shard: each tick it visits one slot, which
+// holds only the reservations due on that tick (or whole wheel turns later), never the rest.
+class ReservationBook {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t WHEEL_SLOTS = 1024;
+
+    struct Counts {
+        int onHand = 0;     // Stock in the inventory, less confirmed lines it has not booked out yet
+        int reserved = 0;   // Held by open reservations
+        int pendingOut = 0; // Confirmed, waiting for drainConfirmed
+        int available() const { return onHand - reserved; }
+    };
+
+    // What the sweeper has done so far
+    struct SweepStats {
+        std::uint64_t ticks = 0;
+        std::uint64_t visited = 0; // Wheel entries looked at
+        std::uint64_t expired = 0;
+        double busyMs = 0;
+    };
+
+private:
+    struct ItemShard {
+        mutable std::mutex mtx;
+        std::unordered_map<std::string, Counts> items;
+    };
+
+    struct Hold {
+        std::vector<std::pair<std::string, int>> lines; // One line per item, in shard order
+        Clock::time_point expires;
+    };
+
+    struct HoldShard {
+        mutable std::mutex mtx;
+        std::unordered_map<std::uint64_t, Hold> holds;
+        std::vector<std::vector<std::pair<std::uint64_t, std::uint64_t>>> wheel; // Per slot: (id, due tick)
+        std::uint64_t swept = 0; // Last tick whose slot the sweeper has visited
+    };
+
+    std::vector<std::unique_ptr<ItemShard>> itemShards;
+    std::vector<std::unique_ptr<HoldShard>> holdShards;
+    std::atomic<std::uint64_t> nextId{1};
+    const Clock::time_point start = Clock::now();
+    const Clock::duration tick;
+    std::mutex confirmedMtx;
+    std::vector<std::pair<std::string, int>> confirmed; // Lines waiting for drainConfirmed
+    std::mutex sweepMtx;
+    std::condition_variable sweepWake;
+    bool stopping = false;
+    SweepStats stats;
+    std::thread sweeper;
+
+    std::size_t shardOf(const std::string& item) const { return std::hash<std::string>{}(item) % itemShards.size(); }
+
+    std::uint64_t tickAt(Clock::time_point t) const { return static_cast<std::uint64_t>((t - start) / tick); }
+
+    // Helper function to lock the item shards of a hold's lines, which are in shard order
+    std::vector<std::unique_lock<std::mutex>> lockItems(const std::vector<std::pair<std::string, int>>& lines) {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        std::size_t last = itemShards.size();
+        for (const auto& line : lines) {
+            std::size_t shard = shardOf(line.first);
+            if (shard != last) locks.emplace_back(itemShards[shard]->mtx);
+            last = shard;
+        }
+        return locks;
+    }
+
+    // Helper function to take an open reservation out of its shard; empty if there is none
+    std::optional<Hold> take(std::uint64_t id) {
+        HoldShard& shard = *holdShards[id % holdShards.size()];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto found = shard.holds.find(id);
+        if (found == shard.holds.end()) return std::nullopt;
+        Hold hold = std::move(found->second);
+        shard.holds.erase(found);
+        return hold;
+    }
+
+    // Helper function to give a hold's stock back
+    void giveBack(const Hold& hold) {
+        auto locks = lockItems(hold.lines);
+        for (const auto& line : hold.lines) itemShards[shardOf(line.first)]->items[line.first].reserved -= line.second;
+    }
+
+    // Helper function to visit the wheel slots of the ticks up to now and release what is due
+    void sweep() {
+        auto began = Clock::now();
+        std::uint64_t now = tickAt(began);
+        std::uint64_t ticks = 0, visited = 0;
+        std::vector<Hold> due;
+        for (auto& shardPtr : holdShards) {
+            HoldShard& shard = *shardPtr;
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            std::uint64_t from = shard.swept + 1;
+            if (now < from) continue;
+            if (now - from >= WHEEL_SLOTS) from = now - WHEEL_SLOTS + 1; // Fell a whole turn behind: each slot once
+            ticks = std::max(ticks, now - from + 1);
+            shard.swept = now;
+            for (std::uint64_t t = from; t <= now; ++t) {
+                auto& slot = shard.wheel[t % WHEEL_SLOTS];
+                visited += slot.size();
+                std::size_t kept = 0;
+                for (auto& entry : slot) {
+                    if (entry.second > now) {
+                        slot[kept++] = entry; // Due on a later turn of the wheel
+                        continue;
+                    }
+                    auto found = shard.holds.find(entry.first);
+                    if (found == shard.holds.end()) continue; // Confirmed or released already
+                    due.push_back(std::move(found->second));
+                    shard.holds.erase(found);
+                }
+                slot.resize(kept);
+            }
+        }
+        for (const Hold& hold : due) giveBack(hold);
+        std::chrono::duration<double, std::milli> busy = Clock::now() - began;
+        std::lock_guard<std::mutex> lock(sweepMtx);
+        stats.ticks += ticks;
+        stats.visited += visited;
+        stats.expired += due.size();
+        stats.busyMs += busy.count();
+    }
+
+public:
+    // Constructor; tick is the granularity of expiry, shards spread items and reservations over locks
+    explicit ReservationBook(std::chrono::milliseconds tickLength = std::chrono::milliseconds(100),
+                             std::size_t shards = 64)
+        : tick(tickLength) {
+        if (shards == 0 || tickLength.count() <= 0) throw std::invalid_argument("Reservation book needs shards and a tick.");
+        for (std::size_t i = 0; i < shards; ++i) {
+            itemShards.push_back(std::make_unique<ItemShard>());
+            holdShards.push_back(std::make_unique<HoldShard>());
+            holdShards.back()->wheel.resize(WHEEL_SLOTS);
+        }
+        sweeper = std::thread([this] {
+            std::unique_lock<std::mutex> lock(sweepMtx);
+            while (!stopping) {
+                sweepWake.wait_for(lock, tick);
+                if (stopping) break;
+                lock.unlock();
+                sweep();
+                lock.lock();
+            }
+        });
+    }
+
+    ReservationBook(const ReservationBook&) = delete;
+    ReservationBook& operator=(const ReservationBook&) = delete;
+
+    ~ReservationBook() {
+        {
+            std::lock_guard<std::mutex> lock(sweepMtx);
+            stopping = true;
+            sweepWake.notify_all();
+        }
+        sweeper.join();
+    }
+
+    // Function to set an item's stock on hand, as the inventory now holds it
+    void setStock(const std::string& item, int quantity) {
+        ItemShard& shard = *itemShards[shardOf(item)];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        Counts& counts = shard.items[item];
+        counts.onHand = quantity - counts.pendingOut;
+    }
+
+    // Function to note that an item left the inventory; its open reservations can no longer be met
+    void forget(const std::string& item) {
+        ItemShard& shard = *itemShards[shardOf(item)];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto found = shard.items.find(item);
+        if (found == shard.items.end()) return;
+        if (found->second.reserved == 0 && found->second.pendingOut == 0) shard.items.erase(found);
+        else found->second.onHand = 0;
+    }
+
+    // Function to drop every item and reservation, for when the inventory is replaced
+    void reset() {
+        for (auto& shard : holdShards) {
+            std::lock_guard<std::mutex> lock(shard->mtx);
+            shard->holds.clear();
+            for (auto& slot : shard->wheel) slot.clear();
+        }
+        for (auto& shard : itemShards) {
+            std::lock_guard<std::mutex> lock(shard->mtx);
+            shard->items.clear();
+        }
+        std::lock_guard<std::mutex> lock(confirmedMtx);
+        confirmed.clear();
+    }
+
+    // Function to hold stock for ttl; returns the reservation id, or 0 with the reason in why if
+    // any line cannot be served, in which case nothing is held
+    std::uint64_t reserve(const std::vector<std::pair<std::string, int>>& lines, std::chrono::milliseconds ttl,
+                          std::string* why = nullptr) {
+        Hold hold;
+        for (const auto& line : lines) {
+            if (line.second <= 0) {
+                if (why) *why = "quantity of " + line.first + " must be positive";
+                return 0;
+            }
+            hold.lines.push_back(line);
+        }
+        if (hold.lines.empty()) {
+            if (why) *why = "nothing to reserve";
+            return 0;
+        }
+        std::sort(hold.lines.begin(), hold.lines.end(), [this](const auto& a, const auto& b) {
+            std::size_t sa = shardOf(a.first), sb = shardOf(b.first);
+            return sa != sb ? sa < sb : a.first < b.first;
+        });
+        std::size_t merged = 0; // An item may appear on several lines
+        for (std::size_t i = 1; i < hold.lines.size(); ++i) {
+            if (hold.lines[i].first == hold.lines[merged].first) hold.lines[merged].second += hold.lines[i].second;
+            else if (++merged != i) hold.lines[merged] = std::move(hold.lines[i]);
+        }
+        hold.lines.resize(merged + 1);
+        {
+            auto locks = lockItems(hold.lines);
+            for (const auto& line : hold.lines) {
+                auto& items = itemShards[shardOf(line.first)]->items;
+                auto found = items.find(line.first);
+                int available = found == items.end() ? 0 : found->second.available();
+                if (available < line.second) {
+                    if (why) *why = "not enough " + line.first + " (" + std::to_string(std::max(0, available)) + " available)";
+                    return 0;
+                }
+            }
+            for (const auto& line : hold.lines) itemShards[shardOf(line.first)]->items[line.first].reserved += line.second;
+        }
+        std::uint64_t id = nextId.fetch_add(1);
+        hold.expires = Clock::now() + ttl;
+        std::uint64_t due = tickAt(hold.expires) + 1; // The first tick that starts after the hold expires
+        HoldShard& shard = *holdShards[id % holdShards.size()];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        due = std::max(due, shard.swept + 1); // The sweeper has passed earlier slots
+        shard.wheel[due % WHEEL_SLOTS].emplace_back(id, due);
+        shard.holds.emplace(id, std::move(hold));
+        return id;
+    }
+
+    // Function to turn a reservation into a sale. The stock leaves the book at once; unless
+    // bookedByCaller, its lines wait in drainConfirmed for the inventory owner to book them out.
+    // Returns false if the reservation is unknown, settled already or expired.
+    bool confirm(std::uint64_t id, bool bookedByCaller = false) {
+        std::optional<Hold> hold = take(id);
+        if (!hold) return false;
+        if (Clock::now() >= hold->expires) { // Expired, the sweeper has not got to it yet
+            giveBack(*hold);
+            return false;
+        }
+        {
+            auto locks = lockItems(hold->lines);
+            for (const auto& line : hold->lines) {
+                Counts& counts = itemShards[shardOf(line.first)]->items[line.first];
+                counts.reserved -= line.second;
+                counts.onHand -= line.second;
+                if (!bookedByCaller) counts.pendingOut += line.second;
+            }
+        }
+        if (!bookedByCaller) {
+            std::lock_guard<std::mutex> lock(confirmedMtx);
+            confirmed.insert(confirmed.end(), hold->lines.begin(), hold->lines.end());
+        }
+        return true;
+    }
+
+    // Function to give a reservation's stock back before it expires; false if it is not open
+    bool release(std::uint64_t id) {
+        std::optional<Hold> hold = take(id);
+        if (!hold) return false;
+        giveBack(*hold);
+        return true;
+    }
+
+    // Function to take the confirmed lines the inventory has not booked out yet. The caller must
+    // book them out (and so call setStock) before the next drain.
+    std::vector<std::pair<std::string, int>> drainConfirmed() {
+        std::vector<std::pair<std::string, int>> lines;
+        {
+            std::lock_guard<std::mutex> lock(confirmedMtx);
+            lines.swap(confirmed);
+        }
+        for (const auto& line : lines) {
+            ItemShard& shard = *itemShards[shardOf(line.first)];
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            Counts& counts = shard.items[line.first];
+            counts.pendingOut -= line.second; // onHand stays low until the booking calls setStock
+        }
+        return lines;
+    }
+
+    // Function to get an item's counts
+    Counts counts(const std::string& item) const {
+        const ItemShard& shard = *itemShards[shardOf(item)];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto found = shard.items.find(item);
+        return found == shard.items.end() ? Counts() : found->second;
+    }
+
+    // Function to list the items that have stock reserved, by name
+    std::vector<std::pair<std::string, Counts>> reservedItems() const {
+        std::vector<std::pair<std::string, Counts>> list;
+        for (const auto& shard : itemShards) {
+            std::lock_guard<std::mutex> lock(shard->mtx);
+            for (const auto& entry : shard->items) {
+                if (entry.second.reserved > 0) list.push_back(entry);
+            }
+        }
+        std::sort(list.begin(), list.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        return list;
+    }
+
+    // Function to count the open reservations
+    std::size_t openCount() const {
+        std::size_t open = 0;
+        for (const auto& shard : holdShards) {
+            std::lock_guard<std::mutex> lock(shard->mtx);
+            open += shard->holds.size();
+        }
+        return open;
+    }
+
+    // Function to get the sweeper's counters
+    SweepStats sweepStats() {
+        std::lock_guard<std::mutex> lock(sweepMtx);
+        return stats;
+    }
+};
+
+// Shared-memory stock table: a copy of every item's stock in a POSIX shared-memory segment, kept
+// up to date by the one process that owns the inventory (SharedStockWriter) and queried in place
+// by any number of local reader processes (SharedStockReader). The layout holds no pointers, only
+// offsets from the start of the segment, so every process can map it at a different address. Each
+// record is protected by a seqlock: the writer makes the sequence odd while it changes the record,
+// and readers retry if the sequence was odd or changed while they copied it, so readers never
+// block the writer or each other.
+
+// One slot of the open-addressing table (two cache lines)
+struct alignas(64) SharedRecord {
+    enum State : std::uint32_t { EMPTY, LIVE, ERASED }; // EMPTY slots were never used and end a probe
+
+    static constexpr std::size_t TYPE_SIZE = 16;
+    static constexpr std::size_t NAME_SIZE = 80; // Longest shared name is NAME_SIZE - 1 bytes
+
+    std::atomic<std::uint32_t> sequence; // Seqlock: odd while the writer changes the record
+    std::atomic<std::uint32_t> state;
+    std::atomic<std::int32_t> quantity;
+    std::atomic<std::int32_t> detail;
+    std::atomic<std::int64_t> cents;
+    std::atomic<std::uint64_t> hash;                // Hash of the name, compared before the name
+    std::atomic<std::uint64_t> type[TYPE_SIZE / 8]; // NUL padded
+    std::atomic<std::uint64_t> name[NAME_SIZE / 8]; // NUL padded
+};
+static_assert(sizeof(SharedRecord) == 128, "SharedRecord must stay two cache lines");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Shared records need address-free atomics");
+
+// Segment header; the records follow at recordsOffset
+struct alignas(64) SharedHeader {
+    static constexpr std::uint64_t MAGIC = 0x4b434f545334534dULL;
+
+    std::uint64_t magic;
+    std::uint32_t capacity;             // Number of slots, a power of two
+    std::uint32_t recordSize;
+    std::uint64_t recordsOffset;
+    std::atomic<std::uint32_t> ready;   // Set once the writer has filled the segment
+    std::atomic<std::uint32_t> retired; // Set when the writer moves to a new segment or exits
+    std::atomic<std::uint64_t> items;   // Live records
+    std::atomic<std::uint64_t> version; // Bumped by every change, so readers can poll for updates
+};
+
+// Stock of one item as copied out of the shared table
+struct SharedItem {
+    char type[SharedRecord::TYPE_SIZE];
+    char name[SharedRecord::NAME_SIZE];
+    int quantity;
+    Money price;
+    int detail;
+};
+
+// Mapping of a shared-memory segment, unmapped and closed on destruction
+class SharedMapping {
+    int fd = -1;
+    void* base = MAP_FAILED;
+    std::size_t length = 0;
+
+public:
+    SharedMapping() = default;
+    SharedMapping(int descriptor, std::size_t size, bool writable) : fd(descriptor), length(size) {
+        base = ::mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            ::close(fd);
+            fd = -1;
+            throw std::runtime_error("Error mapping shared memory.");
+        }
+    }
+    SharedMapping(SharedMapping&& other) noexcept { *this = std::move(other); }
+    SharedMapping& operator=(SharedMapping&& other) noexcept {
+        std::swap(fd, other.fd);
+        std::swap(base, other.base);
+        std::swap(length, other.length);
+        return *this;
+    }
+    ~SharedMapping() {
+        if (base != MAP_FAILED) ::munmap(base, length);
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool mapped() const { return base != MAP_FAILED; }
+    SharedHeader* header() const { return static_cast<SharedHeader*>(base); }
+    SharedRecord* records() const {
+        return reinterpret_cast<SharedRecord*>(static_cast<char*>(base) + header()->recordsOffset);
+    }
+
+    // Helper function to hash an item name (FNV-1a) to its first slot
+    static std::uint64_t hash(const char* name, std::size_t size) {
+        std::uint64_t h = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < size; ++i) h = (h ^ static_cast<unsigned char>(name[i])) * 1099511628211ULL;
+        return h;
+    }
+
+    // Helper functions to move a NUL padded string in and out of a record's words
+    template <std::size_t N>
+    static void storeText(std::atomic<std::uint64_t> (&words)[N], const char* text, std::size_t size) {
+        std::uint64_t local[N] = {};
+        std::memcpy(local, text, std::min(size, N * 8 - 1));
+        for (std::size_t i = 0; i < N; ++i) words[i].store(local[i], std::memory_order_relaxed);
+    }
+
+    template <std::size_t N>
+    static void loadText(const std::atomic<std::uint64_t> (&words)[N], char* out) {
+        std::uint64_t local[N];
+        for (std::size_t i = 0; i < N; ++i) local[i] = words[i].load(std::memory_order_relaxed);
+        std::memcpy(out, local, N * 8);
+        out[N * 8 - 1] = '\0';
+    }
+};
+
+// Writer side: owns the segment and mirrors every change of the inventory into it. When three
+// quarters of the slots are used it moves to a fresh segment without the erased slots, twice the
+// size if more than half of the slots hold live items, otherwise the same size.
+class SharedStockWriter {
+    std::string segmentName;
+    SharedMapping map;
+    std::uint32_t liveSlots = 0;   // Slots that are LIVE
+    std::uint32_t erasedSlots = 0; // Slots that are ERASED (tombstones)
+
+    // Helper function to create and map a fresh segment under the segment name
+    SharedMapping createSegment(std::uint32_t capacity) {
+        int fd = ::shm_open(segmentName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) throw std::runtime_error("Error creating shared memory " + segmentName + ".");
+        if (::flock(fd, LOCK_EX | LOCK_NB) != 0) { // Held while this process owns the segment
+            ::close(fd);
+            throw std::runtime_error("Shared memory " + segmentName + " is owned by another process.");
+        }
+        std::size_t size = sizeof(SharedHeader) + std::size_t(capacity) * sizeof(SharedRecord);
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            ::shm_unlink(segmentName.c_str());
+            throw std::runtime_error("Error sizing shared memory " + segmentName + ".");
+        }
+        SharedMapping fresh(fd, size, true); // ftruncate zero-fills: every slot starts EMPTY
+        SharedHeader* header = fresh.header();
+        header->magic = SharedHeader::MAGIC;
+        header->capacity = capacity;
+        header->recordSize = sizeof(SharedRecord);
+        header->recordsOffset = sizeof(SharedHeader);
+        return fresh;
+    }
+
+    // Helper function to retire a segment left by a previous writer that is no longer running
+    void retireStale() {
+        int fd = ::shm_open(segmentName.c_str(), O_RDWR, 0);
+        if (fd < 0) return;
+        if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Shared memory " + segmentName + " is owned by another process.");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(SharedHeader)) {
+            SharedMapping stale(fd, sizeof(SharedHeader), true);
+            stale.header()->retired.store(1, std::memory_order_release);
+        } else {
+            ::close(fd);
+        }
+        ::shm_unlink(segmentName.c_str());
+    }
+
+    // Helper function to find the slot of a name, or the slot to insert it into
+    std::uint32_t find(const char* name, std::size_t size, bool& live) const {
+        SharedRecord* records = map.records();
+        std::uint32_t mask = map.header()->capacity - 1;
+        std::uint32_t insertAt = UINT32_MAX;
+        char stored[SharedRecord::NAME_SIZE];
+        for (std::uint32_t i = static_cast<std::uint32_t>(SharedMapping::hash(name, size)) & mask;; i = (i + 1) & mask) {
+            std::uint32_t state = records[i].state.load(std::memory_order_relaxed);
+            if (state == SharedRecord::EMPTY) {
+                live = false;
+                return insertAt != UINT32_MAX ? insertAt : i;
+            }
+            if (state == SharedRecord::ERASED) {
+                if (insertAt == UINT32_MAX) insertAt = i;
+                continue;
+            }
+            SharedMapping::loadText(records[i].name, stored);
+            if (std::strncmp(stored, name, size) == 0 && stored[size] == '\0') {
+                live = true;
+                return i;
+            }
+        }
+    }
+
+    // Helper function to rewrite one record under its seqlock
+    template <typename F>
+    static void update(SharedRecord& record, F&& change) {
+        std::uint32_t sequence = record.sequence.load(std::memory_order_relaxed);
+        record.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release); // Odd sequence is visible before the fields change
+        change();
+        record.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Helper function to move every live record into a fresh segment of the given capacity,
+    // dropping the erased slots. Readers probe the old segment until they see it retired, so the
+    // records are never moved under them.
+    void rehash(std::uint32_t capacity) {
+        SharedMapping old = std::move(map);
+        ::shm_unlink(segmentName.c_str()); // Readers keep their mapping until they see the segment retired
+        map = createSegment(capacity);
+        liveSlots = erasedSlots = 0;
+        SharedRecord* records = old.records();
+        for (std::uint32_t i = 0; i < old.header()->capacity; ++i) {
+            if (records[i].state.load(std::memory_order_relaxed) != SharedRecord::LIVE) continue;
+            SharedItem item;
+            SharedMapping::loadText(records[i].type, item.type);
+            SharedMapping::loadText(records[i].name, item.name);
+            store(item.type, item.name, std::strlen(item.name), records[i].quantity.load(std::memory_order_relaxed),
+                  records[i].cents.load(std::memory_order_relaxed), records[i].detail.load(std::memory_order_relaxed));
+        }
+        map.header()->items.store(old.header()->items.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        map.header()->ready.store(1, std::memory_order_release);
+        old.header()->retired.store(1, std::memory_order_release);
+    }
+
+    // Helper function to insert or overwrite a record; returns false if the name was not live
+    bool store(const char* type, const char* name, std::size_t size, int quantity, std::int64_t cents, int detail) {
+        bool live;
+        std::uint32_t slot = find(name, size, live);
+        SharedRecord& record = map.records()[slot];
+        if (!live && record.state.load(std::memory_order_relaxed) == SharedRecord::ERASED) --erasedSlots;
+        if (!live) ++liveSlots;
+        update(record, [&] {
+            record.quantity.store(quantity, std::memory_order_relaxed);
+            record.detail.store(detail, std::memory_order_relaxed);
+            record.cents.store(cents, std::memory_order_relaxed);
+            if (live) return;
+            SharedMapping::storeText(record.type, type, std::strlen(type));
+            SharedMapping::storeText(record.name, name, size);
+            record.hash.store(SharedMapping::hash(name, size), std::memory_order_relaxed);
+            record.state.store(SharedRecord::LIVE, std::memory_order_relaxed);
+        });
+        return live;
+    }
+
+public:
+    // Constructor: creates the segment (replacing one left by a writer that exited) and marks it ready
+    explicit SharedStockWriter(const std::string& name = "/ims_stock", std::uint32_t capacity = 1024)
+        : segmentName(name) {
+        std::uint32_t slots = 16;
+        while (slots < capacity) slots <<= 1;
+        retireStale();
+        map = createSegment(slots);
+        map.header()->ready.store(1, std::memory_order_release);
+    }
+
+    // Destructor: removes the segment; readers see it retired
+    ~SharedStockWriter() {
+        if (!map.mapped()) return;
+        map.header()->retired.store(1, std::memory_order_release);
+        ::shm_unlink(segmentName.c_str());
+    }
+
+    SharedStockWriter(const SharedStockWriter&) = delete;
+    SharedStockWriter& operator=(const SharedStockWriter&) = delete;
+
+    // Function to publish an item's current stock; names too long for a record are not shared
+    void put(const char* type, const std::string& name, int quantity, Money price, int detail) {
+        if (name.size() >= SharedRecord::NAME_SIZE) return;
+        std::uint32_t capacity = map.header()->capacity;
+        if ((liveSlots + erasedSlots + 1) * 4 > capacity * 3)
+            rehash((liveSlots + 1) * 2 > capacity ? capacity * 2 : capacity); // Double only if half the slots are live
+        if (!store(type, name.data(), name.size(), quantity, price.toCents(), detail))
+            map.header()->items.fetch_add(1, std::memory_order_relaxed);
+        map.header()->version.fetch_add(1, std::memory_order_release);
+    }
+
+    // Function to withdraw an item
+    void erase(const std::string& name) {
+        if (name.size() >= SharedRecord::NAME_SIZE) return;
+        bool live;
+        std::uint32_t slot = find(name.data(), name.size(), live);
+        if (!live) return;
+        SharedRecord& record = map.records()[slot];
+        update(record, [&] { record.state.store(SharedRecord::ERASED, std::memory_order_relaxed); });
+        --liveSlots;
+        ++erasedSlots;
+        map.header()->items.fetch_sub(1, std::memory_order_relaxed);
+        map.header()->version.fetch_add(1, std::memory_order_release);
+    }
+
+    // Function to withdraw every item (the segment keeps its size)
+    void clear() {
+        SharedRecord* records = map.records();
+        for (std::uint32_t i = 0; i < map.header()->capacity; ++i) {
+            if (records[i].state.load(std::memory_order_relaxed) != SharedRecord::LIVE) continue;
+            update(records[i], [&] { records[i].state.store(SharedRecord::ERASED, std::memory_order_relaxed); });
+        }
+        erasedSlots += liveSlots;
+        liveSlots = 0;
+        map.header()->items.store(0, std::memory_order_relaxed);
+        map.header()->version.fetch_add(1, std::memory_order_release);
+    }
+};
+
+// Reader side: maps the segment read-only and copies single records out under their seqlock.
+// Lookups never take a lock or talk to the writer; a reader re-attaches by itself when the
+// writer moves to a bigger segment.
+class SharedStockReader {
+    std::string segmentName;
+    SharedMapping map;
+    std::uint64_t retries = 0; // Record copies repeated because the writer was changing the record
+
+    // Helper function to map the current segment, waiting up to a second for the writer to finish filling it
+    void attach() {
+        for (int attempt = 0; attempt < 1000; ++attempt, std::this_thread::sleep_for(std::chrono::milliseconds(1))) {
+            int fd = ::shm_open(segmentName.c_str(), O_RDONLY, 0);
+            if (fd < 0) continue;
+            struct stat info;
+            if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(SharedHeader)) {
+                ::close(fd);
+                continue;
+            }
+            SharedMapping candidate(fd, static_cast<std::size_t>(info.st_size), false);
+            SharedHeader* header = candidate.header();
+            if (header->magic != SharedHeader::MAGIC || !header->ready.load(std::memory_order_acquire)) continue;
+            if (header->retired.load(std::memory_order_acquire)) continue;
+            if (::flock(fd, LOCK_SH | LOCK_NB) == 0) { // Nobody holds the writer's lock: left by a crashed writer
+                ::flock(fd, LOCK_UN);
+                continue;
+            }
+            map = std::move(candidate);
+            return;
+        }
+        throw std::runtime_error("Shared stock " + segmentName + " is not available.");
+    }
+
+    // Helper function to copy one record consistently; returns its state. With a hash given, a
+    // live record of another name is reported as ERASED without being copied.
+    std::uint32_t read(const SharedRecord& record, SharedItem& out, const std::uint64_t* hash = nullptr) {
+        for (;;) {
+            std::uint32_t sequence = record.sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                ++retries;
+                std::this_thread::yield();
+                continue;
+            }
+            std::uint32_t state = record.state.load(std::memory_order_relaxed);
+            if (state == SharedRecord::LIVE && hash && record.hash.load(std::memory_order_relaxed) != *hash) {
+                state = SharedRecord::ERASED;
+            } else if (state == SharedRecord::LIVE) {
+                SharedMapping::loadText(record.type, out.type);
+                SharedMapping::loadText(record.name, out.name);
+                out.quantity = record.quantity.load(std::memory_order_relaxed);
+                out.detail = record.detail.load(std::memory_order_relaxed);
+                out.price = Money::fromCents(record.cents.load(std::memory_order_relaxed));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire); // Field loads complete before the re-check
+            if (record.sequence.load(std::memory_order_relaxed) == sequence) return state;
+            ++retries;
+        }
+    }
+
+    // Helper function to probe the table for a name
+    bool probe(const std::string& name, SharedItem& out) {
+        const SharedRecord* records = map.records();
+        std::uint32_t capacity = map.header()->capacity;
+        std::uint32_t mask = capacity - 1;
+        std::uint64_t hash = SharedMapping::hash(name.data(), name.size());
+        std::uint32_t slot = static_cast<std::uint32_t>(hash) & mask;
+        for (std::uint32_t step = 0; step < capacity; ++step, slot = (slot + 1) & mask) {
+            std::uint32_t state = read(records[slot], out, &hash);
+            if (state == SharedRecord::EMPTY) return false;
+            if (state == SharedRecord::LIVE && name.compare(out.name) == 0) return true;
+        }
+        return false;
+    }
+
+public:
+    // Constructor; throws std::runtime_error if no writer publishes the segment
+    explicit SharedStockReader(const std::string& name = "/ims_stock") : segmentName(name) { attach(); }
+
+    // Function to look up an item's stock; returns false if it does not exist
+    bool lookup(const std::string& name, SharedItem& out) {
+        for (;;) {
+            bool found = probe(name, out);
+            if (!map.header()->retired.load(std::memory_order_acquire)) return found;
+            attach(); // The writer moved to a new segment
+        }
+    }
+
+    // Function to call f on a consistent copy of every item
+    template <typename F>
+    void forEach(F&& f) {
+        const SharedRecord* records = map.records();
+        SharedItem item;
+        for (std::uint32_t i = 0; i < map.header()->capacity; ++i) {
+            if (read(records[i], item) == SharedRecord::LIVE) f(item);
+        }
+    }
+
+    // Function to count the items
+    std::uint64_t size() const { return map.header()->items.load(std::memory_order_relaxed); }
+
+    // Function to read the change counter; it differs whenever the stock changed
+    std::uint64_t version() const { return map.header()->version.load(std::memory_order_acquire); }
+
+    // Function to count the record copies repeated because of concurrent changes
+    std::uint64_t retryCount() const { return retries; }
+};
+
+// Coroutine support for the order pipeline. A few executor threads resume coroutines that are
+// ready to run; a coroutine waiting for queue space, a queue entry or file I/O is parked and holds
+// no thread, so thousands of orders can be in flight on two threads.
+class CoroutineExecutor {
+    std::mutex mtx;
+    std::condition_variable ready;
+    std::deque<std::coroutine_handle<>> runnable;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+
+    void run() {
+        for (;;) {
+            std::coroutine_handle<> next;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                ready.wait(lock, [this] { return stopping || !runnable.empty(); });
+                if (runnable.empty()) return;
+                next = runnable.front();
+                runnable.pop_front();
+            }
+            next.resume();
+        }
+    }
+
+public:
+    explicit CoroutineExecutor(unsigned threadCount = 2) {
+        for (unsigned i = 0; i < std::max(threadCount, 1u); ++i) threads.emplace_back(&CoroutineExecutor::run, this);
+    }
+
+    // Destructor: runs what is still queued, then stops the threads
+    ~CoroutineExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto& thread : threads) thread.join();
+    }
+
+    CoroutineExecutor(const CoroutineExecutor&) = delete;
+    CoroutineExecutor& operator=(const CoroutineExecutor&) = delete;
+
+    // Function to queue a coroutine to be resumed on one of the executor threads. Notifying under
+    // the lock matters: the coroutine may finish the pipeline, whose owner then destroys the executor.
+    void schedule(std::coroutine_handle<> coroutine) {
+        std::lock_guard<std::mutex> lock(mtx);
+        runnable.push_back(coroutine);
+        ready.notify_one();
+    }
+};
+
+// Coroutine that runs detached: it is started with start(executor) and frees itself when it returns
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return DetachedTask{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); } // Stages handle their own errors
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    void start(CoroutineExecutor& executor) { executor.schedule(handle); }
+};
+
+// Bounded queue between two pipeline stages. co_await push(value) parks the producer while the
+// queue is full, which slows earlier stages down to the pace of later ones (backpressure).
+// co_await popBatch(max) parks the consumer until something arrives and then returns everything
+// waiting, up to max, so a stage works in batches that grow when it falls behind. Once the queue
+// is closed and drained, popBatch returns an empty batch.
+template <typename T>
+class StageQueue {
+    struct PopWaiter {
+        std::coroutine_handle<> coroutine;
+        std::vector<T>* out;
+    };
+    struct PushWaiter {
+        std::coroutine_handle<> coroutine;
+        T* value;
+    };
+
+    CoroutineExecutor& executor;
+    std::size_t capacity;
+    std::mutex mtx;
+    std::deque<T> values;
+    std::deque<PopWaiter> poppers;  // Consumers waiting for a value
+    std::deque<PushWaiter> pushers; // Producers waiting for space; their values stay in their frames
+    bool closed = false;
+    std::size_t deepest = 0;  // Largest number of queued values seen
+    std::size_t stalls = 0;   // Pushes that had to wait for space
+
+    // Helper function to move up to max values into out and let parked producers fill the space
+    void take(std::vector<T>& out, std::size_t max) {
+        while (out.size() < max && !values.empty()) {
+            out.push_back(std::move(values.front()));
+            values.pop_front();
+        }
+        while (values.size() < capacity && !pushers.empty()) {
+            values.push_back(std::move(*pushers.front().value));
+            executor.schedule(pushers.front().coroutine);
+            pushers.pop_front();
+        }
+    }
+
+public:
+    StageQueue(CoroutineExecutor& exec, std::size_t maxValues) : executor(exec), capacity(std::max<std::size_t>(maxValues, 1)) {}
+
+    struct PushAwaiter {
+        StageQueue& queue;
+        T value;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> coroutine) {
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            if (!queue.poppers.empty()) { // Hand the value straight to a waiting consumer
+                PopWaiter waiter = queue.poppers.front();
+                queue.poppers.pop_front();
+                waiter.out->push_back(std::move(value));
+                queue.executor.schedule(waiter.coroutine);
+                return false;
+            }
+            if (queue.values.size() < queue.capacity) {
+                queue.values.push_back(std::move(value));
+                queue.deepest = std::max(queue.deepest, queue.values.size());
+                return false;
+            }
+            ++queue.stalls;
+            queue.pushers.push_back(PushWaiter{coroutine, &value});
+            return true;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct PopAwaiter {
+        StageQueue& queue;
+        std::size_t max;
+        std::vector<T> batch;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> coroutine) {
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            if (!queue.values.empty() || queue.closed) {
+                queue.take(batch, max);
+                return false;
+            }
+            queue.poppers.push_back(PopWaiter{coroutine, &batch});
+            return true;
+        }
+        std::vector<T> await_resume() { return std::move(batch); }
+    };
+
+    // Function to queue a value, waiting while the queue is full; must not be called after close()
+    PushAwaiter push(T value) { return PushAwaiter{*this, std::move(value)}; }
+
+    // Function to wait for and take up to max values; empty once closed and drained
+    PopAwaiter popBatch(std::size_t max) { return PopAwaiter{*this, max, {}}; }
+
+    // Function to tell consumers that no more values will come
+    void close() {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        for (const auto& waiter : poppers) executor.schedule(waiter.coroutine); // They wake with an empty batch
+        poppers.clear();
+    }
+
+    std::size_t maxDepth() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return deepest;
+    }
+
+    std::size_t fullStalls() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stalls;
+    }
+};
+
+// Awaitable asynchronous write or sync through AsyncFileIO; the coroutine is resumed on the
+// executor when the I/O completes, and co_await yields the byte count (0 for sync) or -errno
+class FileAwaiter {
+    AsyncFileIO& io;
+    CoroutineExecutor& executor;
+    int fd;
+    bool sync;
+    std::string data;
+    off_t offset;
+    long result = 0;
+
+public:
+    FileAwaiter(AsyncFileIO& files, CoroutineExecutor& exec, int descriptor, bool syncOnly, std::string bytes, off_t at)
+        : io(files), executor(exec), fd(descriptor), sync(syncOnly), data(std::move(bytes)), offset(at) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coroutine) {
+        auto done = [this, coroutine](long r) {
+            result = r;
+            executor.schedule(coroutine);
+        };
+        AsyncFileIO& files = io; // Another coroutine's submit() may complete this request and free *this
+        if (sync) files.enqueueSync(fd, done);
+        else files.enqueueWrite(fd, std::move(data), offset, done);
+        files.submit();
+    }
+    long await_resume() const noexcept { return result; }
+};
+
+// One change inside a batch applied by InventoryManager::applyBatch
+struct Mutation {
+    enum Kind { Add, Remove, Adjust, SetPrice, SetQuantity };
+
+    Kind kind;
+    std::string name;
+    std::string type = ""; // Add: item category
+    int quantity = 0;      // Add, SetQuantity: quantity; Adjust: change in quantity (may be negative)
+    Money price = Money(); // Add, SetPrice: item price
+    int detail = 0;        // Add: warranty or shelf life
+};
+
+// Counters of one order pipeline stage
+struct StageStats {
+    const char* name = "";
+    std::size_t orders = 0;   // Orders the stage handled
+    std::size_t batches = 0;  // Times it woke up to work
+    double busyMs = 0;        // Time spent working, not waiting for orders or I/O
+    std::size_t maxQueue = 0; // Largest number of orders waiting in front of it
+    std::size_t stalls = 0;   // Times the stage in front had to wait because that queue was full
+};
+
+// What happened to one order in the pipeline
+struct OrderOutcome {
+    Order order;
+    std::string problem;            // Why it was rejected; empty if it was confirmed
+    std::vector<std::string> picks; // Pick list in route order, e.g. "A3-S2-B1: 2 x Laptop (lot L1)"
+};
+
+// Result of one run of the order pipeline
+struct PipelineReport {
+    std::vector<OrderOutcome> outcomes; // In the order the orders were submitted
+    std::vector<StageStats> stages;
+    double elapsedMs = 0;
+    double pickMeters = 0; // Length of all pick routes walked
+
+    // Function to print the per-stage throughput and queue depth
+    void printStages(std::ostream& out) const {
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-9s %8s %8s %9s %9s %10s %9s %7s\n", "stage", "orders", "batches", "avg batch",
+                      "busy ms", "orders/s", "max queue", "stalls");
+        out << line;
+        for (const auto& stage : stages) {
+            double perSecond = elapsedMs > 0 ? stage.orders * 1000.0 / elapsedMs : 0;
+            std::snprintf(line, sizeof(line), "%-9s %8zu %8zu %9.1f %9.1f %10.0f %9zu %7zu\n", stage.name, stage.orders,
+                          stage.batches, stage.batches ? double(stage.orders) / stage.batches : 0.0, stage.busyMs, perSecond,
+                          stage.maxQueue, stage.stalls);
+            out << line;
+        }
+        std::snprintf(line, sizeof(line), "%zu orders in %.1f ms, %.0f m of pick routes\n", outcomes.size(), elapsedMs, pickMeters);
+        out << line;
+    }
+};
+
+// One difference between a cycle count and the inventory
+struct CountVariance {
+    enum Status : std::uint8_t { Over, Short, Unknown }; // Unknown: counted, but not in the inventory
+
+    std::string item;
+    std::int64_t book = 0;    // Quantity in the inventory
+    std::int64_t counted = 0; // Sum of the item's count rows
+    Money value;              // (counted - book) x price; zero for unknown items
+    Status status = Over;
+};
+
+// Result of reconciling a cycle count against the inventory
+struct CountReconciliation {
+    std::size_t rows = 0;       // Count rows read
+    std::size_t skus = 0;       // Distinct items counted
+    std::size_t matched = 0;    // Counted items whose count agrees with the inventory
+    std::size_t notCounted = 0; // Inventory items the count does not mention; they are left alone
+    std::vector<CountVariance> variances; // Largest difference in value first
+    std::int64_t netUnits = 0;  // Counted minus book over all over and short items
+    Money netValue;
+    double elapsedMs = 0;
+
+    // Function to print the totals and the first top variances
+    void print(std::ostream& out, std::size_t top) const {
+        static const char* const statuses[] = {"over", "short", "unknown"};
+        char line[160];
+        std::snprintf(line, sizeof(line), "%zu rows, %zu items counted: %zu agree, %zu differ, %zu not counted; %.1f ms\n",
+                      rows, skus, matched, variances.size(), notCounted, elapsedMs);
+        out << line << "Net difference: " << netUnits << " units, " << netValue << "\n";
+        if (variances.empty()) return;
+        std::snprintf(line, sizeof(line), "%-24s %10s %10s %10s %14s %8s\n", "item", "book", "counted", "variance", "value",
+                      "status");
+        out << line;
+        for (std::size_t i = 0; i < variances.size() && i < top; ++i) {
+            const CountVariance& v = variances[i];
+            std::snprintf(line, sizeof(line), "%-24s %10lld %10lld %+10lld %14s %8s\n", v.item.c_str(),
+                          static_cast<long long>(v.book), static_cast<long long>(v.counted),
+                          static_cast<long long>(v.counted - v.book), v.value.toString().c_str(), statuses[v.status]);
+            out << line;
+        }
+        if (variances.size() > top) out << "... and " << variances.size() - top << " more\n";
+    }
+
+    // Function to write every variance as CSV: item,book,counted,variance,value,status
+    void writeCsv(std::ostream& out) const {
+        static const char* const statuses[] = {"over", "short", "unknown"};
+        std::string buffer = "item,book,counted,variance,value,status\n";
+        for (const auto& v : variances) {
+            buffer += v.item;
+            for (std::int64_t number : {v.book, v.counted, v.counted - v.book}) {
+                char digits[24];
+                buffer += ',';
+                buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), number).ptr);
+            }
+            buffer += ',' + v.value.toString() + ',' + statuses[v.status] + '\n';
+            if (buffer.size() >= (1 << 20)) {
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+};
+
+// Inventory Manager to manage inventory and orders
+class InventoryManager {
+    AsyncFileIO io; // Asynchronous file I/O shared by saves, loads and the checkpointer
+    mutable WorkStealingPool pool; // Threads for bulk operations; thread-safe, so const reads use it too
+    Inventory inventory; // Inventory items, stored per category
+    std::deque<Transaction> transactions; // List of transactions (added/removed); a deque never moves old entries
+    OrderQueue orderQueue; // Object to manage orders
+    Checkpointer checkpointer; // Background checkpointer persisting every change
+    ChangeFeed changes; // Change-data-capture stream for downstream consumers
+    std::unique_ptr<SharedStockWriter> shared; // Stock published to other processes, if enabled
+    ReservationBook reservations; // Time-limited holds on stock, by carts and the order pipeline
+    AlertEngine alerts; // Per-item stock rules, checked on every change
+    std::shared_ptr<AlertSubscription> alertInbox = alerts.subscribe(); // Alerts shown between menu actions
+    std::uint32_t coldAfterSeconds = 600; // Items untouched this long are compressed
+    std::uint32_t lastColdSweep = 0;      // When maintain() last looked for idle items
+    std::future<std::string> pendingSave; // Background save started by saveToFile, if any
+    std::unordered_map<std::string, std::vector<Lot>> lots; // Where each item's stock is stored, oldest lot first
+    WarehouseLayout warehouse; // Floor plan used to route pickers
+    std::string shipmentLogPath = "shipments.log"; // Shipment records written by the order pipeline
+    std::string snapshotPath = "inventory.txt";    // File written by "Save to File" and read by "Load from File"
+    PipelineReport lastPipeline; // Statistics of the last order pipeline run
+
+    static constexpr std::size_t RECORD_GRAIN = 4096;      // Records formatted per parallel chunk
+    static constexpr std::size_t SNAPSHOT_CHUNK_ROWS = 2048; // Snapshot rows formatted per chunk
+    static constexpr std::size_t PROGRESS_ITEMS = 100000;  // Bulk operations on fewer items show no progress
+    static constexpr std::size_t COUNT_CHUNK_BYTES = 1 << 20; // Cycle-count file parsed per parallel piece
+
+    // State of one item while a batch is validated
+    struct Draft {
+        bool exists = false;
+        std::string type;
+        int quantity = 0;
+        Money price;
+        int detail = 0;
+    };
+
+    // Helper function to check that a new item name can be stored: records, the replay log and
+    // saved files are comma-separated with the name as the second field
+    static bool validName(const std::string& name) { return !name.empty() && name.find(',') == std::string::npos; }
+
+    // Helper function to format an item as a checkpoint record
+    static std::string toRecord(const std::string& type, const std::string& name, int quantity, Money price, int detail) {
+        char number[16];
+        std::string record;
+        record.reserve(type.size() + name.size() + 48);
+        record += type;
+        record += ',';
+        record += name;
+        record += ',';
+        record.append(number, std::to_chars(number, number + sizeof(number), quantity).ptr);
+        record += ',';
+        price.appendTo(record);
+        record += ',';
+        record.append(number, std::to_chars(number, number + sizeof(number), detail).ptr);
+        return record;
+    }
+
+    template <typename C>
+    static std::string toRecord(const C& item) {
+        return toRecord(C::getType(), item.name, item.quantity, item.price, item.getDetail());
+    }
+
+    // Helper functions to mirror a change into the reservation book, the alert rules and the shared
+    // stock table
+    template <typename C>
+    void share(const C& item) {
+        reservations.setStock(item.name, item.quantity);
+        alerts.check(item.name, item.quantity, item.price, std::is_same_v<C, Perishable> ? item.getDetail() : -1);
+        if (shared) shared->put(C::getType(), item.name, item.quantity, item.price, item.getDetail());
+    }
+
+    void unshare(const std::string& name) {
+        reservations.forget(name);
+        alerts.forget(name);
+        if (shared) shared->erase(name);
+    }
+
+    // Helper function to count how much of an item's stock is stored in bins
+    int binnedQuantity(const std::string& name) const {
+        auto found = lots.find(name);
+        if (found == lots.end()) return 0;
+        int total = 0;
+        for (const auto& lot : found->second) total += lot.quantity;
+        return total;
+    }
+
+    // Helper function to keep an item's lots within its stock after the quantity went down. The
+    // newest lots give way first, so the oldest stock is still picked first.
+    void trimLots(const std::string& name, int quantity) {
+        auto found = lots.find(name);
+        if (found == lots.end()) return;
+        int excess = binnedQuantity(name) - quantity;
+        std::vector<Lot>& itemLots = found->second;
+        while (excess > 0 && !itemLots.empty()) {
+            int take = std::min(excess, itemLots.back().quantity);
+            itemLots.back().quantity -= take;
+            excess -= take;
+            if (itemLots.back().quantity == 0) itemLots.pop_back();
+        }
+        if (itemLots.empty()) lots.erase(found);
+    }
+
+    // Helper function to drop lots of items that no longer exist and trim the others to their stock
+    void reconcileLots() {
+        for (auto it = lots.begin(); it != lots.end();) {
+            int quantity = -1;
+            inventory.visit(it->first, [&](const auto& item) { quantity = item.quantity; });
+            if (quantity < 0) {
+                it = lots.erase(it);
+                continue;
+            }
+            std::string name = (it++)->first; // trimLots may erase the entry
+            trimLots(name, quantity);
+        }
+    }
+
+    // Helper function to show the progress of a bulk operation on screen in steps of 10%; returns
+    // null when the inventory is too small for it to matter
+    std::unique_ptr<ProgressReporter> progressFor(const char* label) const {
+        if (inventory.size() < PROGRESS_ITEMS) return nullptr;
+        return std::make_unique<ProgressReporter>(inventory.size(), [label](std::size_t done, std::size_t total) {
+            std::cout << "\r" << label << ": " << done * 100 / total << "%" << std::flush;
+        }, 10);
+    }
+
+    static constexpr std::size_t PIPELINE_QUEUE = 256; // Orders each queue between two stages holds
+    static constexpr std::size_t PIPELINE_BATCH = 64;  // Most orders a stage takes at once
+    static constexpr unsigned PIPELINE_IO_WORKERS = 4; // Ship and confirm coroutines, each with one I/O in flight
+    static constexpr std::chrono::seconds PIPELINE_HOLD{60}; // How long a reserved order may wait to be picked
+
+    // One order moving through the pipeline
+    struct OrderJob {
+        std::size_t sequence; // Position in the submitted list
+        OrderOutcome outcome;
+        std::uint64_t hold = 0; // Reservation of its stock, from the reserve stage on
+    };
+
+    // State shared by the stage coroutines of one pipeline run. The stages are
+    // validate -> reserve -> pick -> ship -> confirm, joined by bounded queues.
+    struct PipelineRun {
+        enum Stage { Validate, Reserve, Pick, Ship, Confirm, STAGES };
+
+        CoroutineExecutor executor;
+        StageQueue<OrderJob> queues[STAGES] = {{executor, PIPELINE_QUEUE}, {executor, PIPELINE_QUEUE},
+                                               {executor, PIPELINE_QUEUE}, {executor, PIPELINE_QUEUE},
+                                               {executor, PIPELINE_QUEUE}}; // Input queue of each stage
+        std::mutex statsMtx;
+        StageStats stats[STAGES];
+        double pickMeters = 0;
+        std::mutex inventoryMtx; // Held by a stage while it reads or changes the inventory; never across co_await
+        int shipmentLog = -1;
+        std::atomic<off_t> shipmentEnd{0};
+        std::atomic<unsigned> shippers{PIPELINE_IO_WORKERS}; // Ship coroutines still running; the last closes Confirm
+        std::mutex doneMtx;
+        std::condition_variable done;
+        unsigned running = 0; // Coroutines still running
+        std::vector<OrderJob> finished;
+    };
+
+    // Helper function to add a batch's work to a stage's counters
+    static void recordStage(PipelineRun& run, PipelineRun::Stage stage, std::size_t orders,
+                            std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<double, std::milli> busy = std::chrono::steady_clock::now() - start;
+        std::lock_guard<std::mutex> lock(run.statsMtx);
+        run.stats[stage].orders += orders;
+        run.stats[stage].batches += 1;
+        run.stats[stage].busyMs += busy.count();
+    }
+
+    // Helper function to take an order out of the pipeline, confirmed if problem is empty
+    static void finishOrder(PipelineRun& run, OrderJob job, std::string problem) {
+        job.outcome.problem = std::move(problem);
+        std::lock_guard<std::mutex> lock(run.doneMtx);
+        run.finished.push_back(std::move(job));
+    }
+
+    // Helper function called as the last step of every stage coroutine
+    static void leavePipeline(PipelineRun& run) {
+        std::lock_guard<std::mutex> lock(run.doneMtx);
+        if (--run.running == 0) run.done.notify_all();
+    }
+
+    static DetachedTask feedPipeline(PipelineRun& run, std::vector<Order> orders) {
+        for (std::size_t i = 0; i < orders.size(); ++i) {
+            OrderJob job{i, OrderOutcome{std::move(orders[i]), "", {}}}; // Named: GCC 12 mishandles braced temporaries in co_await
+            co_await run.queues[PipelineRun::Validate].push(std::move(job));
+        }
+        run.queues[PipelineRun::Validate].close();
+        leavePipeline(run);
+    }
+
+    // Stage 1: every line names a known item and a positive quantity
+    DetachedTask validateOrders(PipelineRun& run) {
+        for (;;) {
+            std::vector<OrderJob> batch = co_await run.queues[PipelineRun::Validate].popBatch(PIPELINE_BATCH);
+            if (batch.empty()) break;
+            std::chrono::steady_clock::time_point start;
+            std::vector<OrderJob> valid;
+            {
+                std::lock_guard<std::mutex> lock(run.inventoryMtx);
+                start = std::chrono::steady_clock::now(); // Waiting for the lock is not work
+                for (auto& job : batch) {
+                    std::string problem = job.outcome.order.lines.empty() ? "no order lines" : "";
+                    for (const auto& line : job.outcome.order.lines) {
+                        if (line.second <= 0) problem = "quantity of " + line.first + " must be positive";
+                        else if (!inventory.contains(line.first)) problem = "unknown item " + line.first;
+                        if (!problem.empty()) break;
+                    }
+                    if (problem.empty()) valid.push_back(std::move(job));
+                    else finishOrder(run, std::move(job), problem);
+                }
+            }
+            recordStage(run, PipelineRun::Validate, batch.size(), start);
+            for (auto& job : valid) co_await run.queues[PipelineRun::Reserve].push(std::move(job));
+        }
+        run.queues[PipelineRun::Reserve].close();
+        leavePipeline(run);
+    }
+
+    // Stage 2: hold the stock of every line in the reservation book, or of none if any line cannot
+    // be served; the book has its own locks, so this stage does not wait for the inventory
+    DetachedTask reserveStock(PipelineRun& run) {
+        for (;;) {
+            std::vector<OrderJob> batch = co_await run.queues[PipelineRun::Reserve].popBatch(PIPELINE_BATCH);
+            if (batch.empty()) break;
+            auto start = std::chrono::steady_clock::now();
+            std::vector<OrderJob> held;
+            for (auto& job : batch) {
+                std::string problem;
+                job.hold = reservations.reserve(job.outcome.order.lines, PIPELINE_HOLD, &problem);
+                if (job.hold) held.push_back(std::move(job));
+                else finishOrder(run, std::move(job), problem);
+            }
+            recordStage(run, PipelineRun::Reserve, batch.size(), start);
+            for (auto& job : held) co_await run.queues[PipelineRun::Pick].push(std::move(job));
+        }
+        run.queues[PipelineRun::Pick].close();
+        leavePipeline(run);
+    }
+
+    // Stage 3: confirm the batch's reservations, take their lines from the oldest lots, route one
+    // picker through all of their bins, and book the stock out as one atomic batch
+    DetachedTask pickOrders(PipelineRun& run) {
+        for (;;) {
+            std::vector<OrderJob> batch = co_await run.queues[PipelineRun::Pick].popBatch(PIPELINE_BATCH);
+            if (batch.empty()) break;
+            std::size_t taken = batch.size();
+            std::chrono::steady_clock::time_point start;
+            std::vector<OrderJob> picked;
+            {
+                std::lock_guard<std::mutex> lock(run.inventoryMtx);
+                start = std::chrono::steady_clock::now(); // Waiting for the lock is not work
+                std::vector<OrderJob> confirmed;
+                for (auto& job : batch) {
+                    if (reservations.confirm(job.hold, true)) confirmed.push_back(std::move(job));
+                    else finishOrder(run, std::move(job), "reservation expired");
+                }
+                batch.swap(confirmed);
+                std::vector<Mutation> bookOut;
+                std::vector<BinLocation> stops;
+                std::map<BinLocation, std::size_t> stopAt;
+                std::vector<std::vector<std::pair<std::size_t, std::string>>> picksAt; // Per stop: order and what
+                std::unordered_map<std::string, std::vector<Lot>> before; // Lots as they were, in case booking fails
+                std::vector<std::vector<std::string>> unbinned(batch.size()); // Per order: picks from stock not in a bin
+                for (std::size_t j = 0; j < batch.size(); ++j) {
+                    for (const auto& line : batch[j].outcome.order.lines) {
+                        int wanted = line.second;
+                        auto found = lots.find(line.first);
+                        if (found != lots.end()) {
+                            before.try_emplace(line.first, found->second);
+                            std::vector<Lot>& itemLots = found->second;
+                            for (auto& lot : itemLots) {
+                                int take = std::min(wanted, lot.quantity);
+                                if (take == 0) continue;
+                                lot.quantity -= take;
+                                wanted -= take;
+                                auto stop = stopAt.try_emplace(lot.location, stops.size());
+                                if (stop.second) {
+                                    stops.push_back(lot.location);
+                                    picksAt.emplace_back();
+                                }
+                                picksAt[stop.first->second].emplace_back(
+                                    j, std::to_string(take) + " x " + line.first + " (lot " + lot.id + ")");
+                                if (wanted == 0) break;
+                            }
+                            itemLots.erase(std::remove_if(itemLots.begin(), itemLots.end(),
+                                                          [](const Lot& lot) { return lot.quantity == 0; }),
+                                           itemLots.end());
+                            if (itemLots.empty()) lots.erase(found);
+                        }
+                        if (wanted > 0)
+                            unbinned[j].push_back("not in a bin: " + std::to_string(wanted) + " x " + line.first);
+                        Mutation m{Mutation::Adjust, line.first};
+                        m.quantity = -line.second;
+                        bookOut.push_back(m);
+                    }
+                }
+                PickRouter router(warehouse, stops);
+                std::vector<std::size_t> route = router.plan();
+                for (std::size_t stop : route) {
+                    for (auto& pick : picksAt[stop]) batch[pick.first].outcome.picks.push_back(stops[stop].toString() + ": " + pick.second);
+                }
+                for (std::size_t j = 0; j < batch.size(); ++j) {
+                    for (auto& pick : unbinned[j]) batch[j].outcome.picks.push_back(std::move(pick));
+                }
+                std::string problem;
+                try {
+                    applyBatch(bookOut);
+                } catch (const std::exception& e) {
+                    for (auto& entry : before) lots[entry.first] = std::move(entry.second);
+                    for (const auto& m : bookOut) { // The confirmed stock stays in the inventory
+                        if (!inventory.visit(m.name, [&](const auto& item) { share(item); })) unshare(m.name);
+                    }
+                    problem = e.what();
+                }
+                for (auto& job : batch) {
+                    if (problem.empty()) picked.push_back(std::move(job));
+                    else finishOrder(run, std::move(job), problem);
+                }
+                if (problem.empty()) {
+                    std::lock_guard<std::mutex> statsLock(run.statsMtx);
+                    run.pickMeters += router.length(route);
+                }
+            }
+            recordStage(run, PipelineRun::Pick, taken, start);
+            for (auto& job : picked) co_await run.queues[PipelineRun::Ship].push(std::move(job));
+        }
+        run.queues[PipelineRun::Ship].close();
+        leavePipeline(run);
+    }
+
+    // Stage 4: append the batch's shipment records to the shipment log; the write is awaited, so
+    // other batches keep moving while it is in flight
+    DetachedTask shipOrders(PipelineRun& run) {
+        for (;;) {
+            std::vector<OrderJob> batch = co_await run.queues[PipelineRun::Ship].popBatch(PIPELINE_BATCH);
+            if (batch.empty()) break;
+            auto start = std::chrono::steady_clock::now();
+            std::string records;
+            for (const auto& job : batch) {
+                records += "Shipped," + job.outcome.order.name;
+                for (const auto& line : job.outcome.order.lines) records += "," + line.first + " x " + std::to_string(line.second);
+                records += "\n";
+            }
+            long length = static_cast<long>(records.size());
+            off_t at = run.shipmentEnd.fetch_add(length);
+            recordStage(run, PipelineRun::Ship, batch.size(), start);
+            long written = co_await FileAwaiter(io, run.executor, run.shipmentLog, false, std::move(records), at);
+            for (auto& job : batch) {
+                if (written == length) co_await run.queues[PipelineRun::Confirm].push(std::move(job));
+                else finishOrder(run, std::move(job), "shipment record not written (picked stock stays booked out)");
+            }
+        }
+        if (--run.shippers == 0) run.queues[PipelineRun::Confirm].close();
+        leavePipeline(run);
+    }
+
+    // Stage 5: one fsync makes every shipment record written so far durable (group commit), then
+    // the batch's orders are confirmed and published
+    DetachedTask confirmOrders(PipelineRun& run) {
+        for (;;) {
+            std::vector<OrderJob> batch = co_await run.queues[PipelineRun::Confirm].popBatch(PIPELINE_BATCH);
+            if (batch.empty()) break;
+            long synced = co_await FileAwaiter(io, run.executor, run.shipmentLog, true, "", 0);
+            auto start = std::chrono::steady_clock::now();
+            for (auto& job : batch) {
+                if (synced == 0) changes.publish(ChangeEvent::OrderProcessed, job.outcome.order.name);
+                finishOrder(run, std::move(job), synced == 0 ? "" : "shipment log not synced");
+            }
+            recordStage(run, PipelineRun::Confirm, batch.size(), start);
+        }
+        leavePipeline(run);
+    }
+
+    // Helper function to join two partial lists from a parallel reduction
+    template <typename T>
+    static std::vector<T> concat(std::vector<T> a, std::vector<T> b) {
+        if (a.size() < b.size()) std::swap(a, b);
+        a.insert(a.end(), std::make_move_iterator(b.begin()), std::make_move_iterator(b.end()));
+        return a;
+    }
+
+    // Helper function to name a mutation in the transaction history
+    static const char* transactionType(Mutation::Kind kind) {
+        switch (kind) {
+            case Mutation::Add: return "Added";
+            case Mutation::Remove: return "Removed";
+            case Mutation::Adjust: return "Adjusted";
+            case Mutation::SetQuantity: return "Counted";
+            default: return "Repriced";
+        }
+    }
+
+public:
+    // Constructor; the checkpoint, replay log and change log paths can be changed for tests and
+    // benchmarks. Stock is shared with other processes under sharedName unless it is empty.
+    InventoryManager(const std::string& checkpointPath = "inventory.ckpt", const std::string& logPath = "inventory.log",
+                     const std::string& changeLogPath = "changes.log", const std::string& sharedName = "/ims_stock")
+        : checkpointer(io, checkpointPath, logPath), changes(changeLogPath) {
+        if (sharedName.empty()) return;
+        try {
+            shared = std::make_unique<SharedStockWriter>(sharedName);
+        } catch (const std::exception& e) {
+            std::cerr << "Stock sharing disabled: " << e.what() << "\n";
+        }
+    }
+
+    // Destructor: lets a background save finish before the files are closed
+    ~InventoryManager() { reportSave(true); }
+
+    // Function to name the file I/O backend in use ("io_uring" or "thread pool")
+    const char* ioBackend() const { return io.backend(); }
+
+    // Function to access the change stream, e.g. to subscribe a consumer
+    ChangeFeed& changeFeed() { return changes; }
+
+    // Function to access the alert rules, e.g. to subscribe a consumer
+    AlertEngine& alertEngine() { return alerts; }
+
+    // Function to set a stock alert rule on an item and check it at once; returns false if the
+    // item is not in the inventory yet, in which case the rule applies once it is
+    bool setAlertRule(const std::string& name, Alert::Rule rule, std::int64_t limit, std::int32_t hysteresis = 0) {
+        alerts.setRule(name, rule, limit, hysteresis);
+        return inventory.visit(name, [&](const auto& item) { share(item); });
+    }
+
+    // Function to set where the order pipeline writes shipment records
+    void setShipmentLog(const std::string& path) { shipmentLogPath = path; }
+
+    // Function to set the file used by "Save to File" and "Load from File"
+    void setSnapshotFile(const std::string& path) { snapshotPath = path; }
+
+    // Function to get the records a recovery from the checkpoint would restore, in that order
+    std::vector<std::string> checkpointRecords() { return checkpointer.recover(); }
+
+    // Function to set how long an item may stay untouched before it is compressed
+    void setColdAfter(std::chrono::seconds idle) { coldAfterSeconds = static_cast<std::uint32_t>(idle.count()); }
+
+    // Helper function to book the stock of reservations confirmed since the last call out of the
+    // inventory as one batch. Stock that left meanwhile (item removed or counted down) is not
+    // booked twice.
+    void bookOutConfirmed() {
+        std::map<std::string, int> out;
+        for (const auto& line : reservations.drainConfirmed()) out[line.first] += line.second;
+        std::vector<Mutation> batch;
+        for (const auto& entry : out) {
+            inventory.visit(entry.first, [&](const auto& item) {
+                Mutation m{Mutation::Adjust, entry.first};
+                m.quantity = -std::min(entry.second, item.quantity);
+                if (m.quantity != 0) batch.push_back(m);
+                else share(item); // Nothing to book out; the book still has to learn the stock
+            });
+        }
+        if (!batch.empty()) applyBatch(batch);
+    }
+
+    // Function for housekeeping between menu actions: books out confirmed reservations, shows new
+    // alerts and, once a minute, compresses idle items
+    void maintain() {
+        reportSave(false);
+        bookOutConfirmed();
+        std::vector<Alert> news;
+        alertInbox->poll(news);
+        for (const auto& alert : news) std::cout << "Alert " << alert.toString() << "\n";
+        std::uint32_t now = Inventory::now();
+        if (now - lastColdSweep < 60) return;
+        lastColdSweep = now;
+        inventory.freezeIdle(coldAfterSeconds);
+    }
+
+    // Function to apply a batch of mutations atomically: either all of them take effect or none.
+    // Mutations are sorted by name so each item is looked up once, the whole batch is validated
+    // before anything changes, and the batch is logged as a single transaction record and
+    // published to the change feed with a single write.
+    void applyBatch(std::vector<Mutation> batch) {
+        if (batch.empty()) return; // Nothing to log or publish
+        // Sort pointers rather than the mutations, so no names are moved around
+        std::vector<const Mutation*> order(batch.size());
+        for (std::size_t i = 0; i < batch.size(); ++i) order[i] = &batch[i];
+        std::stable_sort(order.begin(), order.end(),
+                         [](const Mutation* a, const Mutation* b) { return a->name < b->name; });
+
+        // Validate: play each item's mutations against a draft of its state
+        std::vector<std::pair<const std::string*, Draft>> finals; // Final state per item
+        std::vector<bool> existed;                                 // Whether the item existed before the batch
+        finals.reserve(order.size());
+        existed.reserve(order.size());
+        for (std::size_t i = 0; i < order.size();) {
+            const std::string& name = order[i]->name;
+            Draft draft;
+            inventory.visit(name, [&](const auto& item) {
+                draft = Draft{true, item.getType(), item.quantity, item.price, item.getDetail()};
+            });
+            existed.push_back(draft.exists);
+            for (; i < order.size() && order[i]->name == name; ++i) {
+                const Mutation& m = *order[i];
+                if (m.kind != Mutation::Add && !draft.exists)
+                    throw std::invalid_argument("Batch rejected: item not found: " + name);
+                switch (m.kind) {
+                    case Mutation::Add:
+                        if (draft.exists) throw std::invalid_argument("Batch rejected: item already exists: " + name);
+                        if (!validName(name)) throw std::invalid_argument("Batch rejected: invalid item name: " + name);
+                        if (!Inventory::withCategory(m.type, [](auto) {}))
+                            throw std::invalid_argument("Batch rejected: invalid item type for " + name);
+                        if (m.quantity < 0 || m.price < Money())
+                            throw std::invalid_argument("Batch rejected: negative quantity or price for " + name);
+                        draft = Draft{true, m.type, m.quantity, m.price, m.detail};
+                        break;
+                    case Mutation::Remove:
+                        draft.exists = false;
+                        break;
+                    case Mutation::Adjust:
+                        if (draft.quantity + m.quantity < 0)
+                            throw std::invalid_argument("Batch rejected: not enough stock of " + name);
+                        draft.quantity += m.quantity;
+                        break;
+                    case Mutation::SetQuantity:
+                        if (m.quantity < 0) throw std::invalid_argument("Batch rejected: negative quantity for " + name);
+                        draft.quantity = m.quantity;
+                        break;
+                    case Mutation::SetPrice:
+                        if (m.price < Money()) throw std::invalid_argument("Batch rejected: negative price for " + name);
+                        draft.price = m.price;
+                        break;
+                }
+            }
+            finals.emplace_back(&name, draft);
+        }
+
+        // Log the whole batch as one transaction record; large batches are formatted in parallel
+        std::vector<std::pair<std::string, std::string>> records(finals.size());
+        pool.parallelFor(0, finals.size(), RECORD_GRAIN, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t i = lo; i < hi; ++i) {
+                const Draft& d = finals[i].second;
+                records[i].first = *finals[i].first;
+                if (d.exists) records[i].second = toRecord(d.type, records[i].first, d.quantity, d.price, d.detail);
+            }
+        });
+        checkpointer.recordBatch(std::move(records));
+
+        // Apply: nothing below can fail validation any more
+        std::vector<ChangeEvent> events;
+        events.reserve(finals.size());
+        auto publish = [&](ChangeEvent::Kind kind, const std::string& name, int quantity = 0, Money price = Money()) {
+            events.push_back(ChangeEvent{0, kind, name, quantity, price}); // Numbered when published
+        };
+        for (std::size_t i = 0; i < finals.size(); ++i) {
+            const std::string& name = *finals[i].first;
+            const Draft& d = finals[i].second;
+            bool updated = false;
+            if (existed[i] && d.exists) {
+                inventory.visit(name, [&](auto& item) {
+                    if (d.type != item.getType() || d.detail != item.getDetail()) return; // Removed and re-added
+                    item.quantity = d.quantity;
+                    item.price = d.price;
+                    share(item);
+                    trimLots(name, d.quantity);
+                    updated = true;
+                });
+            }
+            if (updated) {
+                publish(ChangeEvent::ItemUpdated, name, d.quantity, d.price);
+                continue;
+            }
+            if (existed[i]) {
+                inventory.remove(name);
+                unshare(name);
+                lots.erase(name);
+                publish(ChangeEvent::ItemRemoved, name);
+            }
+            if (d.exists) {
+                Inventory::withCategory(d.type, [&](auto tag) {
+                    using Category = typename decltype(tag)::type;
+                    share(inventory.add(Category(name, d.quantity, d.price, d.detail)));
+                });
+                publish(ChangeEvent::ItemAdded, name, d.quantity, d.price);
+            }
+        }
+        changes.publish(events);
+        for (const auto& m : batch) transactions.emplace_back(m.name, transactionType(m.kind));
+    }
+
+    // Function to add an item to the inventory
+    void addItem() {
+        try {
+            std::string name, type;
+            int quantity; 
+            std::string priceText;
+            std::cout << "Enter item type (Electronic/Perishable): ";
+            std::getline(std::cin, type);
+            std::cout << "Enter name: "; 
+            std::getline(std::cin, name);
+            if (!validName(name)) throw std::invalid_argument("Name must not be empty or contain a comma.");
+            std::cout << "Enter quantity: "; 
+            std::cin >> quantity;
+            if (quantity < 0) throw std::invalid_argument("Quantity cannot be negative.");
+            std::cout << "Enter price: "; 
+            std::cin >> priceText;
+            Money price = Money::parse(priceText);
+            if (price < Money()) throw std::invalid_argument("Price cannot be negative.");
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
+
+            // Handle different item types
+            bool known = Inventory::withCategory(type, [&](auto tag) {
+                using Category = typename decltype(tag)::type;
+                int detail;
+                std::cout << Category::DETAIL_PROMPT; 
+                std::cin >> detail;
+                if (inventory.contains(name)) throw std::invalid_argument("Item already exists.");
+                Category item(name, quantity, price, detail);
+                checkpointer.recordPut(toRecord(item)); // Log the change before it becomes visible
+                share(inventory.add(std::move(item)));
+            });
+            if (!known) throw std::invalid_argument("Invalid item type.");
+            changes.publish(ChangeEvent::ItemAdded, name, quantity, price);
+            transactions.emplace_back(name, "Added");
+            std::cout << "Item added successfully.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to remove an item from the inventory
+    void removeItem() {
+        try {
+            if (inventory.empty()) throw std::runtime_error("No items in inventory.");
+            std::string name;
+            std::cout << "Enter name of the item to remove: ";
+            std::getline(std::cin, name);
+
+            // Find and remove the item from the inventory
+            if (!inventory.remove(name)) throw std::runtime_error("Item not found.");
+            unshare(name);
+            lots.erase(name);
+            checkpointer.recordRemove(name);
+            changes.publish(ChangeEvent::ItemRemoved, name);
+            transactions.emplace_back(name, "Removed");
+            std::cout << "Item removed successfully.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to receive a shipment: all quantities are added in one atomic batch
+    void receiveShipment() {
+        try {
+            std::vector<Mutation> batch;
+            std::string line;
+            std::cout << "Enter received items as name,quantity (empty line to finish):\n";
+            while (std::getline(std::cin, line) && !line.empty()) {
+                std::size_t comma = line.rfind(',');
+                if (comma == std::string::npos) throw std::invalid_argument("Expected name,quantity.");
+                int quantity = std::stoi(line.substr(comma + 1));
+                if (quantity < 0) throw std::invalid_argument("Quantity cannot be negative.");
+                Mutation m{Mutation::Adjust, line.substr(0, comma)};
+                m.quantity = quantity;
+                batch.push_back(m);
+            }
+            applyBatch(batch);
+            std::cout << "Shipment received: " << batch.size() << " items updated.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to display all items in the inventory
+    void displayInventory() const {
+        if (inventory.empty()) {
+            std::cout << "No items in inventory.\n";
+            return;
+        }
+        std::cout << "Inventory:\n";
+        renderReport(inventory, ReportQuery(), std::cout);
+        std::cout << "Total value: " << totalValue() << "\n";
+    }
+
+    // Function to write a filtered, sorted, paged report as a table, CSV or JSON, to the
+    // screen or a file
+    void exportReport() {
+        try {
+            std::string text, path;
+            std::cout << "Enter report query (e.g. type=Electronic quantity<10 sort=-value page=1 size=50 format=csv): ";
+            std::getline(std::cin, text);
+            ReportQuery query = ReportQuery::parse(text);
+            std::cout << "Enter output file (empty for screen): ";
+            std::getline(std::cin, path);
+            if (path.empty()) {
+                renderReport(inventory, query, std::cout);
+                return;
+            }
+            std::ofstream out(path);
+            if (!out) throw std::ios_base::failure("Error opening file.");
+            std::size_t rows = renderReport(inventory, query, out);
+            out.close();
+            if (!out) throw std::ios_base::failure("Error writing file.");
+            std::cout << rows << " rows written to " << path << ".\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to compute the exact value of all stock (quantity x price), in parallel
+    Money totalValue(const CancellationToken& token = CancellationToken(), ProgressReporter* progress = nullptr) const {
+        return inventory.parallelReduce(pool, Money(), [](Money& part, const auto& item) { part += item.price * item.quantity; },
+                                        std::plus<Money>(), token, progress);
+    }
+
+    // Function to reconcile a cycle-count file against the inventory. Rows are "item,quantity"; an
+    // item may have several rows (e.g. one per bin) and a header line is skipped. The file is
+    // mapped and cut into pieces at line ends that are parsed in parallel, each piece sorting its
+    // rows into hash partitions. Every partition then sums its rows into a table on its own thread,
+    // and the inventory is probed against the tables in parallel: a partitioned hash join. Items
+    // the count does not mention are left alone. Nothing changes here; see applyCount.
+    CountReconciliation reconcileCounts(const std::string& path, const CancellationToken& token = CancellationToken()) const {
+        auto start = std::chrono::steady_clock::now();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::ios_base::failure("Error opening " + path + ".");
+        struct stat info;
+        if (::fstat(fd, &info) < 0) {
+            ::close(fd);
+            throw std::ios_base::failure("Error reading " + path + ".");
+        }
+        std::size_t size = static_cast<std::size_t>(info.st_size);
+        void* mapped = size ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0) : nullptr;
+        ::close(fd);
+        if (mapped == MAP_FAILED) throw std::ios_base::failure("Error mapping " + path + ".");
+        struct Unmap {
+            void* data;
+            std::size_t size;
+            ~Unmap() { if (data) ::munmap(data, size); }
+        } unmap{mapped, size};
+        const char* data = static_cast<const char*>(mapped);
+
+        // Parse: piece c holds the lines that start in its COUNT_CHUNK_BYTES of the file
+        using Row = std::pair<std::string_view, int>;
+        const std::size_t parts = pool.size() * 8;
+        auto partOf = [parts](std::string_view name) { return std::hash<std::string_view>{}(name) % parts; };
+        auto lineAt = [&](std::size_t at) -> std::size_t { // Start of the first line at or after at
+            if (at == 0 || at >= size) return std::min(at, size);
+            const void* newline = std::memchr(data + at - 1, '\n', size - at + 1);
+            return newline ? static_cast<const char*>(newline) - data + 1 : size;
+        };
+        std::vector<std::vector<std::vector<Row>>> pieces((size + COUNT_CHUNK_BYTES - 1) / COUNT_CHUNK_BYTES,
+                                                          std::vector<std::vector<Row>>(parts));
+        pool.parallelFor(0, pieces.size(), 1, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t c = lo; c < hi; ++c) {
+                std::size_t at = lineAt(c * COUNT_CHUNK_BYTES), end = lineAt((c + 1) * COUNT_CHUNK_BYTES);
+                while (at < end) {
+                    const char* line = data + at;
+                    const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - at));
+                    std::string_view text(line, newline ? static_cast<std::size_t>(newline - line) : end - at);
+                    at += text.size() + 1;
+                    if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+                    if (text.empty()) continue;
+                    std::size_t comma = text.rfind(',');
+                    int quantity = -1;
+                    if (comma != std::string_view::npos && comma > 0) {
+                        auto parsed = std::from_chars(text.data() + comma + 1, text.data() + text.size(), quantity);
+                        if (parsed.ec != std::errc() || parsed.ptr != text.data() + text.size()) quantity = -1;
+                    }
+                    if (quantity < 0) {
+                        if (line == data) continue; // Header
+                        throw std::invalid_argument("Malformed count row: " + std::string(text));
+                    }
+                    std::string_view name = text.substr(0, comma);
+                    pieces[c][partOf(name)].emplace_back(name, quantity);
+                }
+            }
+        }, token);
+
+        // Build: one table of counted items per partition
+        struct Counted {
+            std::int64_t quantity = 0;
+            bool matched = false; // Found in the inventory; each entry is written by one thread only
+        };
+        std::vector<std::unordered_map<std::string_view, Counted>> tables(parts);
+        CountReconciliation result;
+        result.rows = pool.parallelReduce(0, parts, 1, std::size_t(0), [&](std::size_t lo, std::size_t hi) {
+            std::size_t rows = 0;
+            for (std::size_t p = lo; p < hi; ++p) {
+                std::size_t partRows = 0;
+                for (const auto& piece : pieces) partRows += piece[p].size();
+                tables[p].reserve(partRows);
+                for (auto& piece : pieces) {
+                    for (const Row& row : piece[p]) tables[p][row.first].quantity += row.second;
+                    std::vector<Row>().swap(piece[p]);
+                }
+                rows += partRows;
+            }
+            return rows;
+        }, std::plus<std::size_t>(), token);
+        for (const auto& table : tables) result.skus += table.size();
+
+        // Probe: look every inventory item up in its partition's table
+        struct Probe {
+            std::vector<CountVariance> variances;
+            std::size_t matched = 0, notCounted = 0;
+        };
+        Probe probe = inventory.parallelReduce(pool, Probe(), [&](Probe& part, const auto& item) {
+            auto& table = tables[partOf(item.name)];
+            auto found = table.find(item.name);
+            if (found == table.end()) {
+                ++part.notCounted;
+                return;
+            }
+            found->second.matched = true;
+            std::int64_t difference = found->second.quantity - item.quantity;
+            if (difference == 0) {
+                ++part.matched;
+                return;
+            }
+            part.variances.push_back(CountVariance{item.name, item.quantity, found->second.quantity, item.price * difference,
+                                                   difference > 0 ? CountVariance::Over : CountVariance::Short});
+        }, [](Probe a, Probe b) {
+            a.variances = concat(std::move(a.variances), std::move(b.variances));
+            a.matched += b.matched;
+            a.notCounted += b.notCounted;
+            return a;
+        }, token);
+        std::vector<CountVariance> unknown = pool.parallelReduce(0, parts, 1, std::vector<CountVariance>(),
+            [&](std::size_t lo, std::size_t hi) {
+                std::vector<CountVariance> part;
+                for (std::size_t p = lo; p < hi; ++p) {
+                    for (const auto& entry : tables[p]) {
+                        if (!entry.second.matched)
+                            part.push_back(CountVariance{std::string(entry.first), 0, entry.second.quantity, Money(),
+                                                         CountVariance::Unknown});
+                    }
+                }
+                return part;
+            }, concat<CountVariance>, token);
+
+        result.matched = probe.matched;
+        result.notCounted = probe.notCounted;
+        result.variances = concat(std::move(probe.variances), std::move(unknown));
+        for (const auto& v : result.variances) {
+            if (v.status == CountVariance::Unknown) continue;
+            result.netUnits += v.counted - v.book;
+            result.netValue += v.value;
+        }
+        std::sort(result.variances.begin(), result.variances.end(), [](const CountVariance& a, const CountVariance& b) {
+            std::int64_t x = std::abs(a.value.toCents()), y = std::abs(b.value.toCents());
+            return x != y ? x > y : a.item < b.item;
+        });
+        result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    // Function to book a reconciled count: every item that was over or short is set to its counted
+    // quantity in one atomic batch, logged with a record per item like any other batch. Stock that
+    // moved since the count was reconciled is overwritten by the count, and items removed meanwhile
+    // are skipped. Returns the number of items set.
+    std::size_t applyCount(const CountReconciliation& count) {
+        std::vector<Mutation> batch;
+        for (const auto& v : count.variances) {
+            if (v.status == CountVariance::Unknown || !inventory.contains(v.item)) continue;
+            if (v.counted > std::numeric_limits<int>::max())
+                throw std::out_of_range("Count of " + v.item + " is too large.");
+            Mutation m{Mutation::SetQuantity, v.item};
+            m.quantity = static_cast<int>(v.counted);
+            batch.push_back(std::move(m));
+        }
+        std::size_t adjusted = batch.size();
+        applyBatch(std::move(batch));
+        return adjusted;
+    }
+
+    // Function to write a snapshot of the inventory to path in the background. Only copying the
+    // items happens on the caller's thread, so later changes do not leak into the snapshot; a
+    // background task formats chunks of records in parallel on the pool, queues them as
+    // asynchronous writes, then syncs the file and renames it over path. The future holds "" on
+    // success, otherwise the error.
+    std::future<std::string> saveSnapshot(const std::string& path) {
+        struct Row {
+            const char* type;
+            std::string name;
+            int quantity;
+            Money price;
+            int detail;
+        };
+        std::vector<Row> rows;
+        rows.reserve(inventory.size());
+        inventory.forEach([&](const auto& item) {
+            rows.push_back(Row{item.getType(), item.name, item.quantity, item.price, item.getDetail()});
+        });
+        // After the items come bin placements as "Lot,item,lot,location,quantity", then the alert
+        // rules as "Alert,item,rule,limit,hysteresis"
+        std::string extraLines;
+        for (const auto& entry : lots) {
+            for (const auto& lot : entry.second) {
+                extraLines += "Lot," + entry.first + "," + lot.id + "," + lot.location.toString() + "," +
+                              std::to_string(lot.quantity) + "\n";
+            }
+        }
+        alerts.forEachRule([&](const std::string& item, Alert::Rule rule, std::int64_t limit, std::int32_t band, bool) {
+            extraLines += "Alert," + item + "," + Alert::ruleName(rule) + "," + Alert::formatAmount(rule, limit) + "," +
+                          Alert::formatAmount(rule, band) + "\n";
+        });
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::ios_base::failure("Error opening file.");
+
+        return std::async(std::launch::async, [this, rows = std::move(rows), extraLines = std::move(extraLines), path, tmp,
+                                               fd]() -> std::string {
+            // Format chunks of rows in parallel, then queue them as writes in file order
+            std::vector<std::string> chunks((rows.size() + SNAPSHOT_CHUNK_ROWS - 1) / SNAPSHOT_CHUNK_ROWS);
+            pool.parallelFor(0, chunks.size(), 1, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t c = lo; c < hi; ++c) {
+                    std::size_t last = std::min(rows.size(), (c + 1) * SNAPSHOT_CHUNK_ROWS);
+                    for (std::size_t i = c * SNAPSHOT_CHUNK_ROWS; i < last; ++i) {
+                        const Row& row = rows[i];
+                        chunks[c] += toRecord(row.type, row.name, row.quantity, row.price, row.detail);
+                        chunks[c] += '\n';
+                    }
+                }
+            });
+            if (!extraLines.empty()) chunks.push_back(std::move(extraLines));
+            std::vector<std::pair<std::future<long>, long>> writes; // Result and expected length per chunk
+            off_t offset = 0;
+            for (auto& chunk : chunks) {
+                long length = static_cast<long>(chunk.size());
+                writes.emplace_back(io.enqueueWrite(fd, std::move(chunk), offset), length);
+                offset += length;
+            }
+            io.submit();
+            bool complete = true;
+            for (auto& write : writes) complete = write.first.get() == write.second && complete;
+            std::future<long> sync = io.enqueueSync(fd);
+            io.submit();
+            complete = sync.get() == 0 && complete;
+            ::close(fd);
+            if (!complete) {
+                std::remove(tmp.c_str());
+                return "Error writing file.";
+            }
+            if (std::rename(tmp.c_str(), path.c_str()) != 0) return "Error renaming file.";
+            return "";
+        });
+    }
+
+    // Helper function to report the outcome of a background save; waits for it if wait is set
+    void reportSave(bool wait) {
+        if (!pendingSave.valid()) return;
+        if (!wait && pendingSave.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+        std::string error = pendingSave.get();
+        if (error.empty()) std::cout << "Inventory saved to file.\n";
+        else std::cout << "Error: " << error << "\n";
+    }
+
+    // Function to save inventory data to a file without waiting for the disk
+    void saveToFile() {
+        try {
+            reportSave(true); // One save at a time
+            pendingSave = saveSnapshot(snapshotPath);
+            std::cout << "Saving inventory in the background (" << io.backend() << ").\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Helper function to read a file in chunks with asynchronous read-ahead, passing each line to
+    // f while the following chunks are still being read
+    template <typename F>
+    void readLines(int fd, F&& f) {
+        constexpr std::size_t CHUNK = AsyncFileIO::FIXED_BUFFER_SIZE;
+        constexpr std::size_t AHEAD = 4; // Chunks in flight
+        struct stat info;
+        if (::fstat(fd, &info) != 0) throw std::ios_base::failure("Error reading file.");
+        std::size_t size = static_cast<std::size_t>(info.st_size);
+        std::size_t chunks = (size + CHUNK - 1) / CHUNK;
+        std::vector<std::vector<char>> buffers(std::min(AHEAD, chunks), std::vector<char>(CHUNK));
+        std::deque<std::future<long>> reads;
+        std::size_t next = 0;
+        auto readAhead = [&] {
+            for (; next < chunks && reads.size() < AHEAD; ++next)
+                reads.push_back(io.enqueueRead(fd, buffers[next % AHEAD].data(), CHUNK, static_cast<off_t>(next * CHUNK)));
+            io.submit();
+        };
+        try {
+            std::string line;
+            readAhead();
+            for (std::size_t i = 0; i < chunks; ++i) {
+                long n = reads.front().get();
+                reads.pop_front();
+                if (n != static_cast<long>(std::min(CHUNK, size - i * CHUNK)))
+                    throw std::ios_base::failure("Error reading file.");
+                const char* data = buffers[i % AHEAD].data();
+                for (long at = 0; at < n;) {
+                    const char* end = static_cast<const char*>(std::memchr(data + at, '\n', n - at));
+                    if (!end) {
+                        line.append(data + at, n - at);
+                        break;
+                    }
+                    line.append(data + at, end - (data + at));
+                    f(line);
+                    line.clear();
+                    at = end - data + 1;
+                }
+                readAhead(); // This chunk's buffer is free again
+            }
+            if (!line.empty()) f(line);
+        } catch (...) {
+            for (auto& read : reads) read.wait(); // Reads still target the buffers
+            throw;
+        }
+    }
+
+    // Function to load inventory data from a file, replacing the inventory in one atomic batch.
+    // Lines are "Type,name,quantity,price[,detail]", "Lot,item,lot,location,quantity" or
+    // "Alert,item,rule,limit,hysteresis"; unknown types are skipped.
+    void loadFromFile() {
+        try {
+            reportSave(true); // The file may still be being written
+            int fd = ::open(snapshotPath.c_str(), O_RDONLY);
+            if (fd < 0) throw std::ios_base::failure("Error opening file.");
+            std::vector<Mutation> batch;
+            std::unordered_set<std::string> seen;
+            std::unordered_map<std::string, std::vector<Lot>> loadedLots;
+            std::vector<std::tuple<std::string, Alert::Rule, std::int64_t, std::int64_t>> loadedRules;
+            std::size_t lineNumber = 0;
+            try {
+                readLines(fd, [&](const std::string& line) {
+                    ++lineNumber;
+                    if (line.empty()) return;
+                    std::istringstream in(line);
+                    std::string type, name, quantity, price, detail;
+                    if (!std::getline(in, type, ',') || !std::getline(in, name, ',') ||
+                        !std::getline(in, quantity, ',') || !std::getline(in, price, ','))
+                        throw std::invalid_argument("Malformed line " + std::to_string(lineNumber) + ".");
+                    std::getline(in, detail);
+                    if (type == "Lot") {
+                        // Here the fields are item, lot id, location and quantity
+                        loadedLots[name].push_back(Lot{quantity, BinLocation::parse(price), std::stoi(detail)});
+                        return;
+                    }
+                    if (type == "Alert") {
+                        // Here the fields are item, rule, limit and hysteresis
+                        Alert::Rule rule = Alert::parseRule(quantity);
+                        loadedRules.emplace_back(name, rule, Alert::parseAmount(rule, price), Alert::parseAmount(rule, detail));
+                        return;
+                    }
+                    Inventory::withCategory(type, [&](auto tag) {
+                        using Category = typename decltype(tag)::type;
+                        if (!seen.insert(name).second) return; // Keep the first of duplicate entries
+                        Mutation m{Mutation::Add, name, type};
+                        m.quantity = std::stoi(quantity);
+                        m.price = Money::parse(price);
+                        m.detail = detail.empty() ? Category::DEFAULT_DETAIL : std::stoi(detail);
+                        batch.push_back(m);
+                    });
+                });
+            } catch (...) {
+                ::close(fd);
+                throw;
+            }
+            ::close(fd);
+
+            std::vector<Mutation> replace;
+            replace.reserve(inventory.size() + batch.size());
+            inventory.forEach([&](const auto& item) { replace.push_back(Mutation{Mutation::Remove, item.name}); });
+            replace.insert(replace.end(), batch.begin(), batch.end());
+            applyBatch(std::move(replace));
+            lots = std::move(loadedLots);
+            reconcileLots();
+            // Replace the alert rules; rules that stay keep their state, so raised alerts are not repeated
+            std::set<std::pair<std::string, Alert::Rule>> keep;
+            for (const auto& rule : loadedRules) keep.emplace(std::get<0>(rule), std::get<1>(rule));
+            std::vector<std::pair<std::string, Alert::Rule>> dropped;
+            alerts.forEachRule([&](const std::string& item, Alert::Rule rule, std::int64_t, std::int32_t, bool) {
+                if (!keep.count({item, rule})) dropped.emplace_back(item, rule);
+            });
+            for (const auto& rule : dropped) alerts.removeRule(rule.first, rule.second);
+            for (const auto& rule : loadedRules)
+                alerts.setRule(std::get<0>(rule), std::get<1>(rule), std::get<2>(rule), static_cast<std::int32_t>(std::get<3>(rule)));
+            for (const auto& item : keep) inventory.visit(item.first, [&](const auto& found) { share(found); });
+            std::cout << "Inventory loaded from file.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to rebuild the inventory from the last checkpoint plus the replay log. Every record
+    // is parsed before anything changes, and the inventory is then brought to the recovered state
+    // in one atomic batch holding only the differences, so the change feed sees what recovery did.
+    void recoverFromCheckpoint() {
+        try {
+            std::vector<Mutation> batch;
+            for (const auto& record : checkpointer.recover()) {
+                if (!Checkpointer::validRecord(record)) throw std::invalid_argument("Corrupt checkpoint record: " + record);
+                std::istringstream in(record);
+                std::string type, name, quantity, price, detail;
+                std::getline(in, type, ',');
+                std::getline(in, name, ',');
+                std::getline(in, quantity, ',');
+                std::getline(in, price, ',');
+                std::getline(in, detail);
+                Mutation m{Mutation::Add, name, type};
+                m.quantity = std::stoi(quantity);
+                m.price = Money::parse(price);
+                m.detail = std::stoi(detail);
+                batch.push_back(std::move(m));
+            }
+
+            std::unordered_map<std::string, const Mutation*> recovered;
+            for (const auto& m : batch) recovered.emplace(m.name, &m);
+            std::vector<Mutation> diff;
+            inventory.forEach([&](const auto& item) {
+                auto found = recovered.find(item.name);
+                if (found == recovered.end() || found->second->type != item.getType() ||
+                    found->second->detail != item.getDetail()) {
+                    diff.push_back(Mutation{Mutation::Remove, item.name}); // Gone, or re-added as a different item
+                    return;
+                }
+                const Mutation& m = *found->second;
+                if (m.quantity != item.quantity) {
+                    diff.push_back(Mutation{Mutation::SetQuantity, item.name});
+                    diff.back().quantity = m.quantity;
+                }
+                if (m.price != item.price) {
+                    diff.push_back(Mutation{Mutation::SetPrice, item.name});
+                    diff.back().price = m.price;
+                }
+                recovered.erase(found);
+            });
+            for (const auto& m : batch) {
+                if (recovered.count(m.name)) diff.push_back(m);
+            }
+            applyBatch(std::move(diff));
+            reservations.reset(); // Holds are not checkpointed, so none survive recovery
+            inventory.forEach([&](const auto& item) { reservations.setStock(item.name, item.quantity); });
+            reconcileLots();
+            std::vector<std::string> gone; // Items with alerts that did not come back
+            alerts.forEachRule([&](const std::string& item, Alert::Rule, std::int64_t, std::int32_t, bool firing) {
+                if (firing && !inventory.contains(item)) gone.push_back(item);
+            });
+            for (const auto& item : gone) alerts.forget(item);
+            std::cout << "Recovered " << inventory.size() << " items from checkpoint.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to put part of an item's stock that is not in a bin yet into a bin as a lot; a lot
+    // with the same id in the same bin grows. Throws if the item or enough unbinned stock is missing.
+    void storeLot(const std::string& name, const std::string& id, const BinLocation& location, int quantity) {
+        if (quantity <= 0) throw std::invalid_argument("Quantity must be positive.");
+        int stock = -1;
+        inventory.visit(name, [&](const auto& item) { stock = item.quantity; });
+        if (stock < 0) throw std::runtime_error("Item not found.");
+        int unbinned = stock - binnedQuantity(name);
+        if (quantity > unbinned)
+            throw std::invalid_argument("Only " + std::to_string(unbinned) + " of " + name + " are not in a bin.");
+        std::vector<Lot>& itemLots = lots[name];
+        auto same = std::find_if(itemLots.begin(), itemLots.end(),
+                                 [&](const Lot& lot) { return lot.id == id && lot.location == location; });
+        if (same != itemLots.end()) same->quantity += quantity;
+        else itemLots.push_back(Lot{id, location, quantity});
+    }
+
+    // Function to record where stock is stored
+    void putAwayStock() {
+        try {
+            std::string name, id, where;
+            std::cout << "Enter item name: ";
+            std::getline(std::cin, name);
+            std::cout << "Enter lot id: ";
+            std::getline(std::cin, id);
+            std::cout << "Enter bin location (e.g. A3-S12-B2): ";
+            std::getline(std::cin, where);
+            BinLocation location = BinLocation::parse(where);
+            int quantity = getIntInput("Enter quantity: ");
+            storeLot(name, id, location, quantity);
+            std::cout << "Stored " << quantity << " x " << name << " in " << location.toString() << ".\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to run orders through the staged pipeline (validate, reserve, pick, ship, confirm)
+    // and wait until each one is confirmed or rejected. Stages are coroutines on a two-thread
+    // executor; the caller must not change the inventory while this runs.
+    PipelineReport runOrderPipeline(std::vector<Order> orders) {
+        auto run = std::make_unique<PipelineRun>();
+        run->shipmentLog = ::open(shipmentLogPath.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (run->shipmentLog < 0) throw std::ios_base::failure("Error opening shipment log.");
+        run->shipmentEnd = ::lseek(run->shipmentLog, 0, SEEK_END);
+        std::size_t submitted = orders.size();
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<DetachedTask> tasks{feedPipeline(*run, std::move(orders)), validateOrders(*run), reserveStock(*run),
+                                        pickOrders(*run)};
+        for (unsigned i = 0; i < PIPELINE_IO_WORKERS; ++i) {
+            tasks.push_back(shipOrders(*run));
+            tasks.push_back(confirmOrders(*run));
+        }
+        run->running = static_cast<unsigned>(tasks.size());
+        for (auto& task : tasks) task.start(run->executor);
+        {
+            std::unique_lock<std::mutex> lock(run->doneMtx);
+            run->done.wait(lock, [&] { return run->running == 0; });
+        }
+        ::close(run->shipmentLog);
+
+        PipelineReport report;
+        report.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        report.pickMeters = run->pickMeters;
+        const char* names[PipelineRun::STAGES] = {"validate", "reserve", "pick", "ship", "confirm"};
+        for (int stage = 0; stage < PipelineRun::STAGES; ++stage) {
+            StageStats stats = run->stats[stage];
+            stats.name = names[stage];
+            stats.maxQueue = run->queues[stage].maxDepth();
+            stats.stalls = run->queues[stage].fullStalls();
+            report.stages.push_back(stats);
+        }
+        std::sort(run->finished.begin(), run->finished.end(),
+                  [](const OrderJob& a, const OrderJob& b) { return a.sequence < b.sequence; });
+        for (auto& job : run->finished) report.outcomes.push_back(std::move(job.outcome));
+        if (report.outcomes.size() != submitted) throw std::logic_error("Order pipeline lost orders.");
+        return report;
+    }
+
+    // Function to process every pending order through the pipeline and show what happened
+    void processOrders() {
+        try {
+            std::vector<Order> orders = orderQueue.takeAll();
+            if (orders.empty()) {
+                std::cout << "No orders to process.\n";
+                return;
+            }
+            lastPipeline = runOrderPipeline(std::move(orders));
+            for (const auto& outcome : lastPipeline.outcomes) {
+                if (!outcome.problem.empty()) {
+                    std::cout << outcome.order.name << ": rejected (" << outcome.problem << ")\n";
+                    continue;
+                }
+                std::cout << outcome.order.name << ": confirmed\n";
+                for (const auto& pick : outcome.picks) std::cout << "  " << pick << "\n";
+            }
+            lastPipeline.printStages(std::cout);
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to plan picking for all pending orders at once: each order line is taken from the
+    // item's lots, oldest first, and one picker route through the bins is computed
+    void planPicking() const {
+        struct Pick {
+            std::string item, lot, order;
+            int quantity;
+        };
+        const std::deque<Order>& orders = orderQueue.pending();
+        if (orders.empty()) {
+            std::cout << "No pending orders.\n";
+            return;
+        }
+        std::unordered_map<std::string, std::vector<int>> left; // Per item: what is left in each lot
+        std::vector<BinLocation> stops;
+        std::vector<std::vector<Pick>> picksAt; // Per stop
+        std::map<BinLocation, std::size_t> stopAt;
+        std::vector<std::string> shortages;
+        std::size_t pickCount = 0;
+        for (const auto& order : orders) {
+            for (const auto& line : order.lines) {
+                auto found = lots.find(line.first);
+                auto slot = left.try_emplace(line.first);
+                if (slot.second && found != lots.end()) {
+                    for (const auto& lot : found->second) slot.first->second.push_back(lot.quantity);
+                }
+                int wanted = line.second;
+                for (std::size_t k = 0; k < slot.first->second.size() && wanted > 0; ++k) {
+                    int take = std::min(wanted, slot.first->second[k]);
+                    if (take == 0) continue;
+                    slot.first->second[k] -= take;
+                    wanted -= take;
+                    const Lot& lot = found->second[k];
+                    auto stop = stopAt.try_emplace(lot.location, stops.size());
+                    if (stop.second) {
+                        stops.push_back(lot.location);
+                        picksAt.emplace_back();
+                    }
+                    picksAt[stop.first->second].push_back(Pick{line.first, lot.id, order.name, take});
+                    ++pickCount;
+                }
+                if (wanted > 0)
+                    shortages.push_back(order.name + ": " + std::to_string(wanted) + " x " + line.first + " not in any bin");
+            }
+        }
+
+        PickRouter router(warehouse, stops);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::size_t> route = router.plan();
+        std::chrono::duration<double, std::milli> planned = std::chrono::steady_clock::now() - start;
+        char summary[160];
+        std::snprintf(summary, sizeof(summary), "Pick route for %zu orders: %zu picks at %zu bins, %.1f m (planned in %.2f ms)\n",
+                      orders.size(), pickCount, stops.size(), router.length(route), planned.count());
+        std::cout << summary;
+        for (std::size_t stop : route) {
+            for (const auto& pick : picksAt[stop]) {
+                std::cout << stops[stop].toString() << ": " << pick.quantity << " x " << pick.item << " (lot " << pick.lot
+                          << ") for " << pick.order << "\n";
+            }
+        }
+        for (const auto& shortage : shortages) std::cout << "Short: " << shortage << "\n";
+    }
+
+    // Function to value the whole inventory on all threads; Ctrl+C cancels
+    void revalueInventory() const {
+        CancellationToken token;
+        InterruptCancels interrupt(token);
+        auto progress = progressFor("Revaluing");
+        auto start = std::chrono::steady_clock::now();
+        Money total = totalValue(token, progress.get());
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (progress) std::cout << "\n";
+        if (token.cancelled()) {
+            std::cout << "Revaluation cancelled.\n";
+            return;
+        }
+        char timing[96];
+        std::snprintf(timing, sizeof(timing), " (%zu items, %.1f ms on %zu threads)\n", inventory.size(), elapsed.count(),
+                      pool.size());
+        std::cout << "Total value: " << total << timing;
+    }
+
+    // Function to change the price of every item of a category by a percentage. New prices are
+    // computed on all threads and applied as one atomic batch; Ctrl+C cancels before anything changes.
+    void repriceCategory() {
+        try {
+            std::string type, text;
+            std::cout << "Enter category (Electronic/Perishable): ";
+            std::getline(std::cin, type);
+            if (!Inventory::withCategory(type, [](auto) {})) throw std::invalid_argument("Invalid item type.");
+            std::cout << "Enter price change in percent (e.g. -15 or 2.5): ";
+            std::getline(std::cin, text);
+            std::int64_t basisPoints = Money::parse(text).toCents(); // Hundredths of a percent
+            if (basisPoints <= -10000) throw std::invalid_argument("Prices cannot drop by 100% or more.");
+
+            CancellationToken token;
+            InterruptCancels interrupt(token);
+            auto progress = progressFor("Repricing");
+            std::vector<Mutation> batch = inventory.parallelReduce(pool, std::vector<Mutation>(),
+                [&](std::vector<Mutation>& part, const auto& item) {
+                    if (type != item.getType()) return;
+                    std::int64_t cents = item.price.toCents();
+                    scaleColumn(&cents, 1, 10000 + basisPoints, 10000);
+                    Mutation m{Mutation::SetPrice, item.name};
+                    m.price = Money::fromCents(cents);
+                    part.push_back(std::move(m));
+                }, concat<Mutation>, token, progress.get());
+            if (progress) std::cout << "\n";
+            if (token.cancelled()) {
+                std::cout << "Repricing cancelled; no prices changed.\n";
+                return;
+            }
+            std::size_t count = batch.size();
+            applyBatch(std::move(batch));
+            std::cout << "Repriced " << count << " " << type << " items.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to remove every item in one atomic batch; Ctrl+C cancels before anything changes
+    void removeAllItems() {
+        try {
+            if (inventory.empty()) throw std::runtime_error("No items in inventory.");
+            std::string answer;
+            std::cout << "Remove all " << inventory.size() << " items? (y/n): ";
+            std::getline(std::cin, answer);
+            if (answer != "y" && answer != "Y") {
+                std::cout << "Nothing removed.\n";
+                return;
+            }
+            CancellationToken token;
+            InterruptCancels interrupt(token);
+            auto progress = progressFor("Collecting items");
+            std::vector<Mutation> batch = inventory.parallelReduce(pool, std::vector<Mutation>(),
+                [](std::vector<Mutation>& part, const auto& item) { part.push_back(Mutation{Mutation::Remove, item.name}); },
+                concat<Mutation>, token, progress.get());
+            if (progress) std::cout << "\n";
+            if (token.cancelled()) {
+                std::cout << "Removal cancelled; nothing removed.\n";
+                return;
+            }
+            std::size_t count = batch.size();
+            applyBatch(std::move(batch));
+            std::cout << "Removed " << count << " items.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to reconcile a cycle-count file with the inventory, show and optionally write the
+    // variances, and book them as one batch if confirmed; Ctrl+C cancels the reconciliation
+    void reconcileCycleCount() {
+        try {
+            std::string path, reportPath, answer;
+            std::cout << "Enter count file (rows of item,quantity): ";
+            std::getline(std::cin, path);
+            CancellationToken token;
+            InterruptCancels interrupt(token);
+            CountReconciliation count = reconcileCounts(path, token);
+            if (token.cancelled()) {
+                std::cout << "Reconciliation cancelled.\n";
+                return;
+            }
+            count.print(std::cout, 20);
+            if (count.variances.empty()) return;
+            std::cout << "Enter variance report file (empty for none): ";
+            std::getline(std::cin, reportPath);
+            if (!reportPath.empty()) {
+                std::ofstream out(reportPath);
+                if (!out) throw std::ios_base::failure("Error opening file.");
+                count.writeCsv(out);
+                out.close();
+                if (!out) throw std::ios_base::failure("Error writing file.");
+                std::cout << count.variances.size() << " variances written to " << reportPath << ".\n";
+            }
+            std::cout << "Adjust the inventory to the count? (y/n): ";
+            std::getline(std::cin, answer);
+            if (answer != "y" && answer != "Y") {
+                std::cout << "Nothing adjusted.\n";
+                return;
+            }
+            std::cout << "Adjusted " << applyCount(count) << " items in one batch.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to run bulk operations over the whole inventory
+    void bulkOperations() {
+        int choice;
+        do {
+            std::cout << "Bulk operations run on " << pool.size() << " threads; press Ctrl+C to cancel one.\n";
+            std::cout << "1. Revalue Inventory\n2. Reprice Category\n3. Remove All Items\n4. Reconcile Cycle Count\n5. Back to Main Menu\n";
+            std::cin >> choice;
+            std::cin.ignore();
+            switch (choice) {
+                case 1:
+                    revalueInventory();
+                    break;
+                case 2:
+                    repriceCategory();
+                    break;
+                case 3:
+                    removeAllItems();
+                    break;
+                case 4:
+                    reconcileCycleCount();
+                    break;
+                case 5:
+                    return;
+                default:
+                    std::cout << "Invalid choice.\n";
+            }
+        } while (choice != 5);
+    }
+
+    // Function to reserve stock for a while, e.g. for a cart at checkout
+    void holdStock() {
+        try {
+            std::vector<std::pair<std::string, int>> lines;
+            std::string line;
+            std::cout << "Enter lines to reserve as item,quantity (empty line to finish):\n";
+            while (std::getline(std::cin, line) && !line.empty()) {
+                std::size_t comma = line.rfind(',');
+                if (comma == std::string::npos) throw std::invalid_argument("Expected item,quantity.");
+                lines.emplace_back(line.substr(0, comma), std::stoi(line.substr(comma + 1)));
+            }
+            int seconds = getIntInput("Hold for how many seconds? ");
+            if (seconds <= 0) throw std::invalid_argument("A hold must last at least a second.");
+            std::string problem;
+            std::uint64_t id = reservations.reserve(lines, std::chrono::seconds(seconds), &problem);
+            if (id == 0) throw std::runtime_error("Cannot reserve: " + problem + ".");
+            std::cout << "Reservation " << id << " holds the stock for " << seconds << " seconds.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to confirm or release a reservation
+    void settleReservation(bool confirm) {
+        try {
+            int id = getIntInput("Enter reservation number: ");
+            bool settled = id > 0 && (confirm ? reservations.confirm(static_cast<std::uint64_t>(id))
+                                              : reservations.release(static_cast<std::uint64_t>(id)));
+            if (!settled) throw std::runtime_error("Reservation " + std::to_string(id) + " is not open (expired, confirmed or released).");
+            if (confirm) bookOutConfirmed();
+            std::cout << "Reservation " << id << (confirm ? " confirmed.\n" : " released.\n");
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to display the stock that is held by open reservations
+    void displayReservations() const {
+        auto items = reservations.reservedItems();
+        std::cout << reservations.openCount() << " open reservations.\n";
+        for (const auto& entry : items) {
+            std::cout << entry.first << ": " << entry.second.onHand << " on hand, " << entry.second.reserved
+                      << " reserved, " << entry.second.available() << " available\n";
+        }
+    }
+
+    // Function to manage time-limited reservations
+    void manageReservations() {
+        int choice;
+        do {
+            std::cout << "1. Reserve Stock\n2. Confirm Reservation\n3. Release Reservation\n4. Display Reservations\n5. Back to Main Menu\n";
+            std::cin >> choice;
+            std::cin.ignore();
+            switch (choice) {
+                case 1:
+                    holdStock();
+                    break;
+                case 2:
+                    settleReservation(true);
+                    break;
+                case 3:
+                    settleReservation(false);
+                    break;
+                case 4:
+                    displayReservations();
+                    break;
+                case 5:
+                    return;
+                default:
+                    std::cout << "Invalid choice.\n";
+            }
+        } while (choice != 5);
+    }
+
+    // Function to set a stock alert rule on an item; it is checked at once and on every change
+    void addAlertRule() {
+        try {
+            std::string name, ruleText, limitText, bandText;
+            std::cout << "Enter item name: ";
+            std::getline(std::cin, name);
+            std::cout << "Enter rule (min-quantity, max-quantity, min-value, max-value, expiry): ";
+            std::getline(std::cin, ruleText);
+            Alert::Rule rule = Alert::parseRule(ruleText);
+            std::cout << "Enter limit" << (rule == Alert::Expiry ? " in days of shelf life" : "") << ": ";
+            std::getline(std::cin, limitText);
+            std::int64_t limit = Alert::parseAmount(rule, limitText);
+            std::cout << "Enter hysteresis (empty for none): ";
+            std::getline(std::cin, bandText);
+            std::int64_t band = bandText.empty() ? 0 : Alert::parseAmount(rule, bandText);
+            if (band < 0 || band > std::numeric_limits<std::int32_t>::max()) throw std::invalid_argument("Hysteresis out of range.");
+            if (setAlertRule(name, rule, limit, static_cast<std::int32_t>(band))) std::cout << "Rule set.\n";
+            else std::cout << "Rule set; it applies once " << name << " is in the inventory.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to remove a stock alert rule from an item
+    void removeAlertRule() {
+        try {
+            std::string name, ruleText;
+            std::cout << "Enter item name: ";
+            std::getline(std::cin, name);
+            std::cout << "Enter rule to remove: ";
+            std::getline(std::cin, ruleText);
+            if (!alerts.removeRule(name, Alert::parseRule(ruleText))) throw std::runtime_error("No such rule.");
+            std::cout << "Rule removed.\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Function to display the rules whose alerts are raised
+    void displayAlerts() const {
+        std::vector<std::string> firing;
+        alerts.forEachRule([&](const std::string& item, Alert::Rule rule, std::int64_t limit, std::int32_t band, bool raised) {
+            if (!raised) return;
+            firing.push_back(item + " " + Alert::ruleName(rule) + " " + Alert::formatAmount(rule, limit) +
+                             (band ? " (hysteresis " + Alert::formatAmount(rule, band) + ")" : ""));
+        });
+        std::sort(firing.begin(), firing.end());
+        std::cout << alerts.size() << " rules, " << firing.size() << " raised.\n";
+        for (const auto& line : firing) std::cout << "  " << line << "\n";
+        if (alertInbox->droppedCount()) std::cout << alertInbox->droppedCount() << " alerts were not shown (too many at once).\n";
+    }
+
+    // Function to manage stock alert rules
+    void manageAlerts() {
+        int choice;
+        do {
+            std::cout << "1. Add Alert Rule\n2. Remove Alert Rule\n3. Display Raised Alerts\n4. Back to Main Menu\n";
+            std::cin >> choice;
+            std::cin.ignore();
+            switch (choice) {
+                case 1:
+                    addAlertRule();
+                    break;
+                case 2:
+                    removeAlertRule();
+                    break;
+                case 3:
+                    displayAlerts();
+                    break;
+                case 4:
+                    return;
+                default:
+                    std::cout << "Invalid choice.\n";
+            }
+        } while (choice != 4);
+    }
+
+    // Function to manage orders
+    void manageOrders() {
+        int choice;
+        do {
+            std::cout << "1. Add Order\n2. Process Orders\n3. Display Orders\n4. Plan Pick Route\n5. Pipeline Statistics\n6. Back to Main Menu\n";
+            std::cin >> choice; 
+            std::cin.ignore();
+            switch (choice) {
+                case 1: {
+                    Order order;
+                    std::cout << "Enter order name: "; 
+                    std::getline(std::cin, order.name);
+                    try {
+                        std::string line;
+                        std::cout << "Enter order lines as item,quantity (empty line to finish):\n";
+                        while (std::getline(std::cin, line) && !line.empty()) {
+                            std::size_t comma = line.rfind(',');
+                            if (comma == std::string::npos) throw std::invalid_argument("Expected item,quantity.");
+                            int quantity = std::stoi(line.substr(comma + 1));
+                            if (quantity <= 0) throw std::invalid_argument("Quantity must be positive.");
+                            order.lines.emplace_back(line.substr(0, comma), quantity);
+                        }
+                    } catch (const std::exception& e) {
+                        std::cout << "Error: " << e.what() << "\n";
+                        break;
+                    }
+                    orderQueue.addOrder(order);
+                    changes.publish(ChangeEvent::OrderAdded, order.name);
+                    break;
+                }
+                case 2:
+                    processOrders();
+                    break;
+                case 3: 
+                    orderQueue.displayOrders(); 
+                    break;
+                case 4:
+                    planPicking();
+                    break;
+                case 5:
+                    if (lastPipeline.stages.empty()) std::cout << "No orders processed yet.\n";
+                    else lastPipeline.printStages(std::cout);
+                    break;
+                case 6: 
+                    return;
+                default: 
+                    std::cout << "Invalid choice.\n";
+            }
+        } while (choice != 6);
+    }
+
+    // Helper function to get an integer input with validation
+    int getIntInput(const std::string& prompt) {
+        int value;
+        std::cout << prompt;
+        while (!(std::cin >> value)) {
+            std::cin.clear(); 
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::cout << "Invalid input. Please enter a valid integer: ";
+        }
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
+        return value;
+    }
+};
+
+// Benchmarks, run from the command line: ims_advanced_cpp --bench <name> [items]
+
+// Helper function to time one pass of f and return the cost per item in nanoseconds
+template <typename F>
+double nanosPerItem(std::size_t items, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return items ? elapsed.count() / items : 0.0;
+}
+
+// Polymorphic item hierarchy as it was before the category registry, kept for comparison
+struct VirtualItem {
+    std::string name;
+    int quantity;
+    float price;
+    VirtualItem(std::string n, int q, float p) : name(std::move(n)), quantity(q), price(p) {}
+    virtual ~VirtualItem() = default;
+    virtual std::string getType() const = 0;
+    virtual int getDetail() const = 0;
+};
+
+struct VirtualElectronic : VirtualItem {
+    int warranty;
+    VirtualElectronic(std::string n, int q, float p, int w) : VirtualItem(std::move(n), q, p), warranty(w) {}
+    std::string getType() const override { return "Electronic"; }
+    int getDetail() const override { return warranty; }
+};
+
+struct VirtualPerishable : VirtualItem {
+    int shelfLife;
+    VirtualPerishable(std::string n, int q, float p, int s) : VirtualItem(std::move(n), q, p), shelfLife(s) {}
+    std::string getType() const override { return "Perishable"; }
+    int getDetail() const override { return shelfLife; }
+};
+
+// Benchmark: per-item scan cost (type name, detail and value, as saveToFile needs them)
+// through virtual calls versus the statically dispatched per-category loops
+void benchmarkScan(std::size_t items) {
+    std::vector<std::unique_ptr<VirtualItem>> legacy;
+    Inventory store;
+    for (std::size_t i = 0; i < items; ++i) {
+        std::string name = "item" + std::to_string(i);
+        int quantity = static_cast<int>(i % 100);
+        Money price = Money::fromCents(static_cast<std::int64_t>(i % 1000) * 10);
+        if (i % 2) {
+            legacy.push_back(std::make_unique<VirtualElectronic>(name, quantity, price.toCents() / 100.0f, 12));
+            store.add(Electronic(name, quantity, price, 12));
+        } else {
+            legacy.push_back(std::make_unique<VirtualPerishable>(name, quantity, price.toCents() / 100.0f, 7));
+            store.add(Perishable(name, quantity, price, 7));
+        }
+    }
+
+    double legacySum = 0, storeSum = 0;
+    double legacyNs = nanosPerItem(items, [&] {
+        for (const auto& item : legacy)
+            legacySum += item->quantity * item->price + item->getType().size() + item->getDetail();
+    });
+    double storeNs = nanosPerItem(items, [&] {
+        store.forEach([&](const auto& item) {
+            storeSum += item.quantity * item.price.toCents() / 100.0 + std::char_traits<char>::length(item.getType()) +
+                        item.getDetail();
+        });
+    });
+    std::cout << "scan " << items << " items\n";
+    std::cout << "  virtual calls:   " << legacyNs << " ns/item (checksum " << legacySum << ")\n";
+    std::cout << "  category loops:  " << storeNs << " ns/item (checksum " << storeSum << ")\n";
+}
+
+// Helper function to give a benchmark its own checkpoint files in the temp directory
+std::string benchmarkPath(const std::string& file) {
+    const char* dir = std::getenv("TMPDIR");
+    std::string path = std::string(dir ? dir : "/tmp") + "/ims_bench_" + std::to_string(::getpid()) + "_" + file;
+    std::remove(path.c_str());
+    return path;
+}
+
+// Benchmark: receiving a stock adjustment for every item one call at a time versus one batch
+void benchmarkBatch(std::size_t items) {
+    std::string data = benchmarkPath("batch.ckpt"), log = benchmarkPath("batch.log");
+    std::string changeLog = benchmarkPath("batch.changes");
+    {
+        InventoryManager manager(data, log, changeLog, "");
+        std::vector<Mutation> adds, adjusts;
+        for (std::size_t i = 0; i < items; ++i) {
+            Mutation add{Mutation::Add, "item" + std::to_string(i), "Electronic"};
+            add.quantity = 10;
+            add.price = Money::fromCents(150);
+            add.detail = 12;
+            adds.push_back(add);
+            Mutation adjust{Mutation::Adjust, add.name};
+            adjust.quantity = 1;
+            adjusts.push_back(adjust);
+        }
+        manager.applyBatch(adds);
+
+        double singleNs = nanosPerItem(items, [&] {
+            for (const auto& m : adjusts) manager.applyBatch({m});
+        });
+        double batchNs = nanosPerItem(items, [&] { manager.applyBatch(adjusts); });
+        std::cout << "batch " << items << " adjustments\n";
+        std::cout << "  one call per item: " << singleNs << " ns/item\n";
+        std::cout << "  single batch:      " << batchNs << " ns/item (" << singleNs / batchNs << "x)\n";
+    }
+    for (const auto& path : {data, log, log + ".old", changeLog}) std::remove(path.c_str());
+}
+
+// Benchmark: publishing cost with one consumer keeping up and one stalled consumer whose ring
+// overflows; the stalled one then catches up from the change log with nothing lost
+void benchmarkChangeFeed(std::size_t events) {
+    std::string changeLog = benchmarkPath("feed.changes");
+    {
+        ChangeFeed feed(changeLog);
+        auto live = feed.subscribe(1024);
+        auto stalled = feed.subscribe(64);
+        std::vector<ChangeEvent> received;
+        std::size_t liveCount = 0;
+        double publishNs = nanosPerItem(events, [&] {
+            for (std::size_t i = 0; i < events; ++i) {
+                feed.publish(ChangeEvent::ItemUpdated, "item" + std::to_string(i % 1000), static_cast<int>(i), Money::fromCents(100));
+                if (i % 512 == 0) {
+                    liveCount += live->poll(received);
+                    received.clear();
+                }
+            }
+        });
+        liveCount += live->poll(received);
+        received.clear();
+        std::uint64_t expected = 1;
+        bool ordered = true;
+        while (stalled->poll(received)) {
+            for (const auto& event : received) ordered = ordered && event.sequence == expected++;
+            received.clear();
+        }
+        std::cout << "cdc " << events << " events\n";
+        std::cout << "  publish:          " << publishNs << " ns/event\n";
+        std::cout << "  live consumer:    " << liveCount << " events\n";
+        std::cout << "  stalled consumer: " << expected - 1 << " events after catching up from the log"
+                  << (ordered ? " (in order)" : " (OUT OF ORDER)") << "\n";
+    }
+    std::remove(changeLog.c_str());
+}
+
+// Helper function to read the heap memory currently allocated (0 where it cannot be measured)
+std::size_t heapInUse() {
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// Benchmark: memory of a catalog before and after compressing it, and lookup latency of hot
+// items versus cold items (which are decompressed on access)
+void benchmarkColdTier(std::size_t items) {
+    std::size_t baseline = heapInUse();
+    Inventory store;
+    for (std::size_t i = 0; i < items; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "sku-%08zu-widget", i);
+        Money price = Money::fromCents(static_cast<std::int64_t>(i % 5000));
+        if (i % 2) store.add(Electronic(name, static_cast<int>(i % 500), price, 12));
+        else store.add(Perishable(name, static_cast<int>(i % 500), price, 7));
+    }
+    std::size_t hotBytes = heapInUse() - baseline;
+
+    std::vector<std::string> sample;
+    for (std::size_t i = 0; i < 1000 && items; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "sku-%08zu-widget", (i * 7919) % items);
+        sample.emplace_back(name);
+    }
+    long checksum = 0;
+    double hotNs = nanosPerItem(sample.size(), [&] {
+        for (const auto& name : sample) store.visit(name, [&](const auto& item) { checksum += item.quantity; });
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t frozen = store.freezeIdle(0);
+    std::chrono::duration<double, std::milli> freezeMs = std::chrono::steady_clock::now() - start;
+    std::size_t coldBytes = heapInUse() - baseline;
+
+    double coldNs = nanosPerItem(sample.size(), [&] {
+        for (const auto& name : sample) store.visit(name, [&](const auto& item) { checksum += item.quantity; });
+    });
+    std::cout << "cold " << items << " items (" << frozen << " frozen in " << freezeMs.count() << " ms)\n";
+    std::cout << "  hot memory:   " << hotBytes / 1024 << " KiB\n";
+    std::cout << "  cold memory:  " << coldBytes / 1024 << " KiB (" << (coldBytes ? double(hotBytes) / coldBytes : 0)
+              << "x smaller)\n";
+    std::cout << "  hot lookup:   " << hotNs << " ns\n";
+    std::cout << "  cold lookup:  " << coldNs << " ns (includes decompression; checksum " << checksum << ")\n";
+}
+
+// Benchmark: valuation, a 15% discount and a currency conversion over price columns, using
+// float prices (as before) versus the exact cents kernels
+void benchmarkMoneyKernels(std::size_t items) {
+    std::vector<std::int32_t> quantities(items);
+    std::vector<std::int64_t> cents(items);
+    std::vector<float> prices(items);
+    std::uint64_t seed = 42;
+    for (std::size_t i = 0; i < items; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        quantities[i] = static_cast<std::int32_t>((seed >> 33) % 1000);
+        cents[i] = static_cast<std::int64_t>((seed >> 13) % 100000);
+        prices[i] = Money::fromCents(cents[i]).toCents() / 100.0f;
+    }
+
+    // Exact reference results computed one item at a time with 128-bit arithmetic
+    __int128 exactValue = 0;
+    std::vector<std::int64_t> discounted(items), converted(items);
+    for (std::size_t i = 0; i < items; ++i) {
+        exactValue += static_cast<__int128>(quantities[i]) * cents[i];
+        discounted[i] = static_cast<std::int64_t>((static_cast<__int128>(cents[i]) * 8500 + 5000) / 10000);
+        converted[i] = static_cast<std::int64_t>((static_cast<__int128>(cents[i]) * 1084000 + 500000) / 1000000);
+    }
+
+    float floatValue = 0;
+    double floatValueNs = nanosPerItem(items, [&] {
+        for (std::size_t i = 0; i < items; ++i) floatValue += quantities[i] * prices[i];
+    });
+    Money value;
+    double valueNs = nanosPerItem(items, [&] { value = columnValue(quantities.data(), cents.data(), items); });
+
+    std::vector<float> floatPrices = prices;
+    double floatDiscountNs = nanosPerItem(items, [&] {
+        for (auto& price : floatPrices) price *= 0.85f;
+    });
+    std::vector<std::int64_t> column = cents;
+    double discountNs = nanosPerItem(items, [&] { discountColumn(column.data(), items, 1500); });
+    bool discountExact = column == discounted;
+
+    floatPrices = prices;
+    double floatConvertNs = nanosPerItem(items, [&] {
+        for (auto& price : floatPrices) price *= 1.084f;
+    });
+    column = cents;
+    double convertNs = nanosPerItem(items, [&] { convertColumn(column.data(), items, 1084000); });
+    bool convertExact = column == converted;
+
+    std::cout << "money " << items << " items" << (useAvx2() ? " (AVX2)" : "") << "\n";
+    std::cout << "  valuation: float " << floatValueNs << " ns/item, off by "
+              << static_cast<double>(floatValue) - static_cast<double>(exactValue) / 100 << "; cents " << valueNs
+              << " ns/item, " << (value.toCents() == static_cast<std::int64_t>(exactValue) ? "exact" : "WRONG") << "\n";
+    std::cout << "  discount:  float " << floatDiscountNs << " ns/item; cents " << discountNs << " ns/item, "
+              << (discountExact ? "exact" : "WRONG") << "\n";
+    std::cout << "  convert:   float " << floatConvertNs << " ns/item; cents " << convertNs << " ns/item, "
+              << (convertExact ? "exact" : "WRONG") << "\n";
+}
+
+// Benchmark: printing the whole inventory to a file the old way (item.display() through
+// std::cout, and with a flush per line as std::endl does) versus the streaming report engine
+void benchmarkReport(std::size_t items) {
+    Inventory store;
+    std::uint64_t seed = 42;
+    for (std::size_t i = 0; i < items; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::string name = "item" + std::to_string(i);
+        int quantity = static_cast<int>((seed >> 33) % 1000);
+        Money price = Money::fromCents(static_cast<std::int64_t>((seed >> 13) % 100000));
+        if (i % 2) store.add(Electronic(name, quantity, price, 12));
+        else store.add(Perishable(name, quantity, price, 7));
+    }
+    std::string file = benchmarkPath("report.txt");
+
+    // Helper function to time writing one report to the file; returns milliseconds
+    auto timed = [&](auto&& write) {
+        std::ofstream out(file);
+        auto start = std::chrono::steady_clock::now();
+        write(out);
+        out.close();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    double displayMs = timed([&](std::ofstream& out) {
+        std::streambuf* screen = std::cout.rdbuf(out.rdbuf()); // As if stdout were redirected to the file
+        store.forEach([](const auto& item) { item.display(); });
+        std::cout.rdbuf(screen);
+    });
+    double endlMs = timed([&](std::ofstream& out) {
+        store.forEach([&](const auto& item) {
+            out << item.getType() << "\t" << item.name << "\t" << item.quantity << "\t" << item.price << std::endl;
+        });
+    });
+    std::cout << "report " << items << " rows to a file\n";
+    std::cout << "  display(): " << displayMs << " ms\n";
+    std::cout << "  std::endl per row: " << endlMs << " ms\n";
+    for (const char* text : {"format=table", "format=csv", "format=json", "sort=-value", "sort=-value page=1000 size=50",
+                             "type=Electronic quantity<100 columns=name,quantity format=csv"}) {
+        ReportQuery query = ReportQuery::parse(text);
+        std::size_t rows = 0;
+        double ms = timed([&](std::ofstream& out) { rows = renderReport(store, query, out); });
+        std::cout << "  " << text << ": " << ms << " ms (" << rows << " rows)\n";
+    }
+    std::remove(file.c_str());
+}
+
+// Benchmark: route length and planning time for batched picking. The same random picks are
+// walked as a sweep of every aisle, order by order (five picks per order, one trip each), and as
+// one batch routed by each heuristic.
+void benchmarkPickRoute(std::size_t maxPicks) {
+    WarehouseLayout layout;
+    const int aisles = 20, bins = 4;
+    std::uint64_t seed = 7;
+    auto next = [&seed](int bound) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<int>((seed >> 33) % static_cast<std::uint64_t>(bound));
+    };
+    std::cout << "pick routes in " << aisles << " aisles x " << layout.shelves << " shelves x " << bins << " bins\n";
+    for (std::size_t picks : {50, 100, 200, 500, 1000}) {
+        if (picks > maxPicks) break;
+        std::vector<BinLocation> stops;
+        std::set<BinLocation> seen;
+        while (stops.size() < picks) {
+            BinLocation location{next(aisles), next(layout.shelves), next(bins)};
+            if (seen.insert(location).second) stops.push_back(location);
+        }
+        PickRouter router(layout, stops);
+        double sweep = 2 * layout.aisleLength() * ((aisles + 1) / 2) + 2 * (aisles - 1) * layout.aislePitch;
+        double orderByOrder = 0;
+        for (std::size_t start = 0; start < stops.size(); start += 5) {
+            std::vector<BinLocation> order(stops.begin() + start, stops.begin() + std::min(start + 5, stops.size()));
+            PickRouter single(layout, order);
+            orderByOrder += single.length(single.plan());
+        }
+        // Helper function to time one route construction; returns milliseconds
+        auto timed = [](auto&& build, std::vector<std::size_t>& route) {
+            auto start = std::chrono::steady_clock::now();
+            route = build();
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+        std::vector<std::size_t> shape, nearest, improved, best;
+        double shapeMs = timed([&] { return router.sShape(); }, shape);
+        double nearestMs = timed([&] { return router.nearestNeighbor(); }, nearest);
+        double improvedMs = timed([&] {
+            std::vector<std::size_t> route = router.nearestNeighbor();
+            router.twoOpt(route);
+            return route;
+        }, improved);
+        double bestMs = timed([&] { return router.plan(); }, best);
+        char line[320];
+        std::snprintf(line, sizeof(line),
+                      "  %4zu picks: sweep %.0f m, order by order %.0f m, s-shape %.0f m (%.2f ms), nearest %.0f m "
+                      "(%.2f ms), nearest+2-opt %.0f m (%.2f ms), plan %.0f m (%.2f ms)\n",
+                      picks, sweep, orderByOrder, router.length(shape), shapeMs, router.length(nearest), nearestMs,
+                      router.length(improved), improvedMs, router.length(best), bestMs);
+        std::cout << line;
+    }
+}
+
+// Benchmark: speedup of bulk operations on the work-stealing pool from 1 thread up to the number
+// of cores (at least 4, to show oversubscription on small machines): valuation, an in-place 10%
+// repricing, formatting every item as a record, and a skewed workload where a few chunks cost far
+// more than the rest. Also measures how quickly a cancelled operation returns.
+void benchmarkParallel(std::size_t items) {
+    Inventory store;
+    std::uint64_t seed = 42;
+    for (std::size_t i = 0; i < items; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::string name = "item" + std::to_string(i);
+        int quantity = static_cast<int>((seed >> 33) % 1000);
+        Money price = Money::fromCents(static_cast<std::int64_t>((seed >> 13) % 100000));
+        if (i % 2) store.add(Electronic(name, quantity, price, 12));
+        else store.add(Perishable(name, quantity, price, 7));
+    }
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<unsigned> counts;
+    for (unsigned n = 1; n < std::max(cores, 4u); n *= 2) counts.push_back(n);
+    counts.push_back(std::max(cores, 4u));
+
+    // Helper function to time one run; returns milliseconds
+    auto timed = [](auto&& run) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    std::cout << "parallel " << items << " items, " << cores << " cores\n";
+    std::cout << "  threads   value ms   reprice ms   format ms   skewed ms   speedup (value/reprice/format/skewed)   steals\n";
+    double base[4] = {0, 0, 0, 0};
+    for (unsigned threads : counts) {
+        WorkStealingPool pool(threads);
+        Money value, expected;
+        store.forEach([&](const auto& item) { expected += item.price * item.quantity; });
+        double ms[4];
+        ms[0] = timed([&] {
+            value = store.parallelReduce(pool, Money(), [](Money& part, const auto& item) { part += item.price * item.quantity; },
+                                         std::plus<Money>());
+        });
+        ms[1] = timed([&] {
+            store.parallelForEach(pool, [](auto& item) {
+                std::int64_t cents = item.price.toCents();
+                scaleColumn(&cents, 1, 11000, 10000);
+                item.price = Money::fromCents(cents);
+            });
+        });
+        std::size_t bytes = 0;
+        ms[2] = timed([&] {
+            bytes = store.parallelReduce(pool, std::size_t(0), [](std::size_t& part, const auto& item) {
+                std::string record = item.getType();
+                record += "," + item.name + "," + std::to_string(item.quantity) + "," + item.price.toString() + "," +
+                          std::to_string(item.getDetail()) + "\n";
+                part += record.size();
+            }, std::plus<std::size_t>());
+        });
+        // One chunk in 16 is 50x as expensive, as when a few items need much more work
+        std::atomic<std::uint64_t> sink{0};
+        std::size_t chunks = std::max<std::size_t>(items / 1024, 1);
+        ms[3] = timed([&] {
+            pool.parallelFor(0, chunks, 1, [&](std::size_t lo, std::size_t hi) {
+                std::uint64_t h = 0;
+                for (std::size_t c = lo; c < hi; ++c) {
+                    std::size_t rounds = (c * 2654435761u) % 16 == 0 ? 50 * 16384 : 16384;
+                    for (std::size_t r = 0; r < rounds; ++r) h = h * 31 + r;
+                }
+                sink += h;
+            });
+        });
+        if (threads == 1) std::copy(ms, ms + 4, base);
+        char line[200];
+        std::snprintf(line, sizeof(line), "  %7u %10.1f %12.1f %11.1f %11.1f   %6.2fx %6.2fx %6.2fx %6.2fx %15zu%s\n",
+                      threads, ms[0], ms[1], ms[2], ms[3], base[0] / ms[0], base[1] / ms[1], base[2] / ms[2],
+                      base[3] / ms[3], pool.steals(), threads > cores ? "  (more threads than cores)" : "");
+        std::cout << line;
+        if (value != expected || bytes == 0) std::cout << "  WRONG: parallel valuation differs from a sequential pass\n";
+    }
+
+    // Cancellation: cancel a repricing pass shortly after it starts
+    WorkStealingPool pool(cores);
+    CancellationToken token;
+    ProgressReporter progress(items, [](std::size_t, std::size_t) {});
+    std::chrono::steady_clock::time_point cancelledAt;
+    std::thread canceller([&] {
+        while (progress.completed() < items / 10) std::this_thread::yield();
+        cancelledAt = std::chrono::steady_clock::now();
+        token.cancel();
+    });
+    store.parallelForEach(pool, [](auto& item) { item.price = item.price + Money::fromCents(1); }, token, &progress);
+    auto returned = std::chrono::steady_clock::now();
+    canceller.join();
+    std::cout << "  cancel at 10%: returned after " << std::chrono::duration<double, std::micro>(returned - cancelledAt).count()
+              << " us, " << progress.completed() * 100 / std::max<std::size_t>(items, 1) << "% of items done\n";
+}
+
+// Benchmark: orders pushed through the staged pipeline all at once versus one at a time (each
+// order then waits for its own shipment write and fsync), with per-stage statistics
+void benchmarkPipeline(std::size_t orders) {
+    std::string data = benchmarkPath("pipeline.ckpt"), log = benchmarkPath("pipeline.log");
+    std::string changeLog = benchmarkPath("pipeline.changes"), shipments = benchmarkPath("shipments.log");
+    {
+        InventoryManager manager(data, log, changeLog, "");
+        manager.setShipmentLog(shipments);
+        const std::size_t items = 1000;
+        std::vector<Mutation> adds;
+        for (std::size_t i = 0; i < items; ++i) {
+            Mutation add{Mutation::Add, "item" + std::to_string(i), "Electronic"};
+            add.quantity = 1000000;
+            add.price = Money::fromCents(1999);
+            add.detail = 12;
+            adds.push_back(add);
+        }
+        manager.applyBatch(adds);
+        std::uint64_t seed = 11;
+        auto next = [&seed](std::size_t bound) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<std::size_t>((seed >> 33) % bound);
+        };
+        for (std::size_t i = 0; i < items; ++i)
+            manager.storeLot(adds[i].name, "L" + std::to_string(i),
+                             BinLocation{static_cast<int>(next(20)), static_cast<int>(next(50)), static_cast<int>(next(4))}, 500000);
+        auto makeOrders = [&](std::size_t count) {
+            std::vector<Order> list(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                list[i].name = "Order " + std::to_string(i);
+                for (std::size_t lines = 1 + next(3); lines > 0; --lines)
+                    list[i].lines.emplace_back(adds[next(items)].name, static_cast<int>(1 + next(5)));
+            }
+            return list;
+        };
+
+        std::size_t single = std::min<std::size_t>(orders, 500);
+        std::vector<Order> one = makeOrders(single);
+        auto start = std::chrono::steady_clock::now();
+        for (auto& order : one) manager.runOrderPipeline({order});
+        double singleMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        PipelineReport report = manager.runOrderPipeline(makeOrders(orders));
+        std::size_t confirmed = 0;
+        for (const auto& outcome : report.outcomes) confirmed += outcome.problem.empty();
+        std::cout << "pipeline " << orders << " orders\n";
+        std::cout << "  one order at a time: " << single * 1000.0 / singleMs << " orders/s (" << single << " orders)\n";
+        std::cout << "  all in flight:       " << orders * 1000.0 / report.elapsedMs << " orders/s, " << confirmed
+                  << " confirmed\n";
+        std::ostringstream stages;
+        report.printStages(stages);
+        std::istringstream lines(stages.str());
+        for (std::string line; std::getline(lines, line);) std::cout << "  " << line << "\n";
+    }
+    for (const auto& file : {data, log, changeLog, shipments}) std::remove(file.c_str());
+}
+
+// Benchmark of the reservation book: reserve/settle throughput of many threads with one lock and
+// with sharded locks, then how much work the sweeper does to expire short holds among long ones
+void benchmarkReservations(std::size_t holds) {
+    unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+    const std::size_t items = 10000;
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < items; ++i) names.push_back("item" + std::to_string(i));
+    std::cout << "reserve " << holds << " holds, " << threads << " threads\n";
+    auto flashSale = [&](std::size_t shards, bool hotItem) {
+        ReservationBook book(std::chrono::milliseconds(100), shards);
+        for (const auto& name : names) book.setStock(name, 1000000000);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::uint64_t seed = t + 1;
+                for (std::size_t i = t; i < holds; i += threads) {
+                    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                    const std::string& name = names[hotItem ? 0 : (seed >> 33) % items];
+                    std::uint64_t id = book.reserve({{name, 1}}, std::chrono::seconds(60));
+                    if (i % 2) book.confirm(id, true);
+                    else book.release(id);
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return holds * 1000.0 / ms;
+    };
+    std::cout << "  reserve + settle, one lock:      " << flashSale(1, false) << " holds/s\n";
+    std::cout << "  reserve + settle, 64 shards:     " << flashSale(64, false) << " holds/s\n";
+    std::cout << "  reserve + settle, one hot item:  " << flashSale(64, true) << " holds/s\n";
+
+    ReservationBook book(std::chrono::milliseconds(100));
+    for (const auto& name : names) book.setStock(name, 1000000000);
+    std::uint64_t seed = 7;
+    for (std::size_t i = 0; i < holds; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        bool shortHold = i % 2 == 0;
+        auto ttl = std::chrono::milliseconds(shortHold ? 100 + (seed >> 33) % 900 : 600000);
+        book.reserve({{names[(seed >> 33) % items], 1}}, ttl);
+    }
+    std::size_t shortHolds = (holds + 1) / 2;
+    auto start = std::chrono::steady_clock::now();
+    while (book.openCount() > holds - shortHolds && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ReservationBook::SweepStats stats = book.sweepStats();
+    std::cout << "  expired " << stats.expired << " of " << shortHolds << " short holds among " << holds - shortHolds
+              << " long ones over " << stats.ticks << " ticks\n";
+    std::cout << "  sweeper: " << stats.busyMs << " ms busy, " << stats.visited << " wheel entries visited ("
+              << (stats.expired ? static_cast<double>(stats.visited) / stats.expired : 0.0) << " per expiry); scanning every hold each tick would visit ~"
+              << stats.ticks * (holds - shortHolds) << "\n";
+}
+
+// Benchmark: cost of alert rules on the write path. The same batches of adjustments run without
+// rules and again with rules on every item plus many more on other names; the adjustments move
+// stock back and forth across a min-quantity limit, and hysteresis keeps that to one alert per item
+void benchmarkAlerts(std::size_t rules) {
+    std::string data = benchmarkPath("alerts.ckpt"), log = benchmarkPath("alerts.log");
+    std::string changeLog = benchmarkPath("alerts.changes");
+    {
+        InventoryManager manager(data, log, changeLog, "");
+        const std::size_t items = std::min<std::size_t>(rules, 100000);
+        std::vector<Mutation> adds, down, up;
+        for (std::size_t i = 0; i < items; ++i) {
+            Mutation add{Mutation::Add, "item" + std::to_string(i), "Perishable"};
+            add.quantity = 10;
+            add.price = Money::fromCents(150);
+            add.detail = 7;
+            adds.push_back(add);
+            Mutation adjust{Mutation::Adjust, add.name};
+            adjust.quantity = -1;
+            down.push_back(adjust);
+            adjust.quantity = 1;
+            up.push_back(adjust);
+        }
+        manager.applyBatch(adds);
+        auto hover = [&] {
+            return nanosPerItem(4 * items, [&] {
+                for (int pass = 0; pass < 2; ++pass) {
+                    manager.applyBatch(down);
+                    manager.applyBatch(up);
+                }
+            });
+        };
+        double without = hover();
+
+        AlertEngine& engine = manager.alertEngine();
+        auto inbox = engine.subscribe(1 << 20);
+        for (std::size_t i = 0; i < items; ++i) {
+            manager.setAlertRule(adds[i].name, Alert::MinQuantity, 10, 5);
+            manager.setAlertRule(adds[i].name, Alert::MaxValue, 100000);
+        }
+        for (std::size_t i = 2 * items; i < rules; ++i) engine.setRule("other" + std::to_string(i), Alert::MinQuantity, 1);
+        double with = hover();
+        std::vector<Alert> delivered;
+        inbox->poll(delivered, delivered.max_size());
+
+        std::uint64_t seed = 5;
+        const std::size_t checks = 1000000;
+        double checkNs = nanosPerItem(checks, [&] {
+            for (std::size_t i = 0; i < checks; ++i) {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                engine.check(adds[(seed >> 33) % items].name, 12, Money::fromCents(150), 7);
+            }
+        });
+        std::cout << "alerts " << engine.size() << " rules on " << items << " items\n";
+        std::cout << "  adjustments without rules: " << without << " ns/item\n";
+        std::cout << "  adjustments with rules:    " << with << " ns/item (" << (with / without - 1) * 100 << "%)\n";
+        std::cout << "  one rule check:            " << checkNs << " ns\n";
+        std::cout << "  " << 4 * items << " adjustments around the limit raised " << delivered.size() << " alerts\n";
+    }
+    for (const auto& path : {data, log, log + ".old", changeLog}) std::remove(path.c_str());
+}
+
+// Benchmark: reconciling a cycle count of the given number of rows (ten per item, one in a
+// thousand for an item that is not in the inventory, and about 2% of items off) with the parallel
+// partitioned hash join, against reading it line by line with one lookup per row
+void benchmarkReconcile(std::size_t rows) {
+    std::string data = benchmarkPath("count.ckpt"), log = benchmarkPath("count.log");
+    std::string changeLog = benchmarkPath("count.changes"), countFile = benchmarkPath("count.csv");
+    {
+        InventoryManager manager(data, log, changeLog, "");
+        const std::size_t items = std::max<std::size_t>(1, rows / 10);
+        std::vector<Mutation> adds;
+        Inventory store; // The same items, for the row-by-row baseline
+        for (std::size_t i = 0; i < items; ++i) {
+            Mutation add{Mutation::Add, "SKU" + std::to_string(i), "Electronic"};
+            add.quantity = i % 97 == 0 ? 12 : i % 89 == 0 ? 7 : 10;
+            add.price = Money::fromCents(100 + static_cast<std::int64_t>(i % 5000));
+            add.detail = 12;
+            store.add(Electronic(add.name, add.quantity, add.price, add.detail));
+            adds.push_back(std::move(add));
+        }
+        manager.applyBatch(adds);
+        {
+            std::ofstream out(countFile);
+            std::string buffer;
+            for (std::size_t r = 0; r < rows; ++r) {
+                buffer += r % 1000 == 999 ? "LOST" + std::to_string(r) : adds[r % items].name;
+                buffer += ",1\n";
+                if (buffer.size() >= (1 << 20)) {
+                    out << buffer;
+                    buffer.clear();
+                }
+            }
+            out << buffer;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::unordered_map<std::string, std::int64_t> counted;
+        std::size_t differ = 0;
+        {
+            std::ifstream in(countFile);
+            std::string line;
+            while (std::getline(in, line)) {
+                std::size_t comma = line.rfind(',');
+                std::string name = line.substr(0, comma);
+                int quantity = std::stoi(line.substr(comma + 1));
+                store.visit(name, [](const auto&) {}); // The per-row lookup being replaced
+                counted[name] += quantity;
+            }
+            for (const auto& entry : counted)
+                store.visit(entry.first, [&](const auto& item) { differ += item.quantity != entry.second; });
+        }
+        double rowByRowMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        CountReconciliation count = manager.reconcileCounts(countFile);
+        start = std::chrono::steady_clock::now();
+        std::size_t adjusted = manager.applyCount(count);
+        double applyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "reconcile " << rows << " rows against " << items << " items\n";
+        std::cout << "  row by row:         " << rowByRowMs << " ms (" << differ << " items differ)\n";
+        std::cout << "  partitioned join:   " << count.elapsedMs << " ms (" << rowByRowMs / count.elapsedMs << "x), "
+                  << count.variances.size() << " variances\n";
+        std::cout << "  apply as one batch: " << applyMs << " ms for " << adjusted << " adjustments\n";
+        CountReconciliation again = manager.reconcileCounts(countFile);
+        std::cout << "  after applying:     " << again.variances.size() << " variances left (items not in the inventory)\n";
+    }
+    for (const auto& path : {data, log, log + ".old", changeLog, countFile}) std::remove(path.c_str());
+}
+
+// Helper function to summarize latencies (in microseconds) as p50 / p99 / max
+std::string latencySummary(std::vector<double> micros) {
+    if (micros.empty()) return "no samples";
+    std::sort(micros.begin(), micros.end());
+    std::ostringstream out;
+    out << "p50 " << micros[micros.size() / 2] << " us, p99 " << micros[micros.size() * 99 / 100] << " us, max "
+        << micros.back() << " us (" << micros.size() << " ops)";
+    return out.str();
+}
+
+// Benchmark: a large save done the old way (formatted and written on the caller's thread) versus
+// the asynchronous snapshot, and the latency of foreground operations while the snapshot is written
+void benchmarkAsyncSave(std::size_t items) {
+    std::string data = benchmarkPath("save.ckpt"), log = benchmarkPath("save.log");
+    std::string changeLog = benchmarkPath("save.changes");
+    std::string blockingFile = benchmarkPath("blocking.txt"), asyncFile = benchmarkPath("async.txt");
+    {
+        InventoryManager manager(data, log, changeLog, "");
+        std::vector<Mutation> adds;
+        for (std::size_t i = 0; i < items; ++i) {
+            Mutation add{Mutation::Add, "item" + std::to_string(i), "Electronic"};
+            add.quantity = 10;
+            add.price = Money::fromCents(150);
+            add.detail = 12;
+            adds.push_back(add);
+        }
+        manager.applyBatch(adds);
+
+        // Foreground operation: a one-item stock adjustment, logged like any menu action
+        std::size_t next = 0;
+        auto operation = [&] {
+            Mutation adjust{Mutation::Adjust, adds[next++ % items].name};
+            adjust.quantity = 1;
+            auto start = std::chrono::steady_clock::now();
+            manager.applyBatch({adjust});
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        };
+        std::vector<double> idle;
+        for (int i = 0; i < 2000; ++i) idle.push_back(operation());
+
+        // Blocking save: while it runs, no foreground operation can start
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::ofstream out(blockingFile);
+            for (const auto& add : adds)
+                out << add.type << "," << add.name << "," << add.quantity << "," << add.price << "," << add.detail << "\n";
+            out.flush();
+            int fd = ::open(blockingFile.c_str(), O_RDONLY);
+            ::fsync(fd);
+            ::close(fd);
+        }
+        std::chrono::duration<double, std::milli> blockingMs = std::chrono::steady_clock::now() - start;
+
+        // Asynchronous save: only formatting happens on this thread
+        start = std::chrono::steady_clock::now();
+        std::future<std::string> saved = manager.saveSnapshot(asyncFile);
+        std::chrono::duration<double, std::milli> callMs = std::chrono::steady_clock::now() - start;
+        std::vector<double> during;
+        while (saved.wait_for(std::chrono::seconds(0)) != std::future_status::ready) during.push_back(operation());
+        std::string error = saved.get();
+        std::chrono::duration<double, std::milli> durableMs = std::chrono::steady_clock::now() - start;
+
+        std::cout << "asyncsave " << items << " items (" << manager.ioBackend() << ")\n";
+        std::cout << "  blocking save:     " << blockingMs.count() << " ms on the caller's thread\n";
+        std::cout << "  async save:        " << callMs.count() << " ms on the caller's thread, durable after "
+                  << durableMs.count() << " ms" << (error.empty() ? "" : " (" + error + ")") << "\n";
+        std::cout << "  ops while idle:    " << latencySummary(idle) << "\n";
+        std::cout << "  ops during save:   " << latencySummary(during) << "\n";
+    }
+    for (const auto& path : {data, log, log + ".old", changeLog, blockingFile, asyncFile}) std::remove(path.c_str());
+}
+
+// Benchmark: lookups from separate reader processes against the shared stock table while the
+// writer keeps changing stock, versus finding items the old way (in a saved inventory file)
+void benchmarkSharedStock(std::size_t items) {
+    const std::size_t lookups = 1000000; // Per reader process
+    std::string segment = "/ims_bench_" + std::to_string(::getpid());
+    SharedStockWriter writer(segment); // Starts small, so filling it also exercises growth
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < items; ++i) {
+        names.push_back("item" + std::to_string(i));
+        writer.put("Electronic", names.back(), 0, Money::fromCents(150), 0); // Quantity and detail always match
+    }
+
+    std::cout << "shm " << items << " items, " << lookups << " lookups per reader\n";
+    for (unsigned readers : {1u, 2u, 4u}) {
+        int results[2];
+        if (::pipe(results) != 0) throw std::runtime_error("Error creating pipe.");
+        std::vector<pid_t> children;
+        for (unsigned r = 0; r < readers; ++r) {
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                ::close(results[0]);
+                SharedStockReader reader(segment);
+                SharedItem item;
+                std::size_t torn = 0, missing = 0;
+                std::uint64_t seed = 12345 + r;
+                auto start = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < lookups; ++i) {
+                    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                    if (!reader.lookup(names[(seed >> 33) % items], item)) ++missing;
+                    else if (item.quantity != item.detail) ++torn;
+                }
+                std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+                char line[128];
+                int length = std::snprintf(line, sizeof(line), "%f %llu %zu %zu\n", elapsed.count() / lookups,
+                                           static_cast<unsigned long long>(reader.retryCount()), torn, missing);
+                ssize_t written = ::write(results[1], line, length);
+                ::_exit(written == length ? 0 : 1);
+            }
+            children.push_back(pid);
+        }
+        ::close(results[1]);
+
+        // Keep changing stock while the readers run
+        std::size_t updates = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t running = children.size(); running > 0;) {
+            for (int i = 0; i < 64; ++i, ++updates) {
+                int quantity = static_cast<int>(updates % 1000);
+                writer.put("Electronic", names[(updates * 7919) % items], quantity, Money::fromCents(150), quantity);
+            }
+            while (running > 0 && ::waitpid(-1, nullptr, WNOHANG) > 0) --running;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::string output;
+        char buffer[512];
+        for (ssize_t n; (n = ::read(results[0], buffer, sizeof(buffer))) > 0;) output.append(buffer, n);
+        ::close(results[0]);
+        std::istringstream in(output);
+        double nanos, totalNanos = 0;
+        unsigned long long retries, totalRetries = 0;
+        std::size_t torn, missing, totalTorn = 0, totalMissing = 0;
+        unsigned reported = 0;
+        while (in >> nanos >> retries >> torn >> missing) {
+            totalNanos += nanos;
+            totalRetries += retries;
+            totalTorn += torn;
+            totalMissing += missing;
+            ++reported;
+        }
+        std::cout << "  " << readers << " reader" << (readers > 1 ? "s: " : ":  ") << (reported ? totalNanos / reported : 0)
+                  << " ns/lookup, " << reported * lookups / elapsed.count() / 1e6 << " M lookups/s in total, "
+                  << updates / elapsed.count() / 1e6 << " M writer updates/s, " << totalRetries << " retries, "
+                  << totalTorn << " torn, " << totalMissing << " missing\n";
+    }
+
+    // Before: the only way to read stock from another process was to parse a saved file
+    std::string file = benchmarkPath("shm.txt");
+    {
+        std::ofstream out(file);
+        for (const auto& name : names) out << "Electronic," << name << ",0,1.50,0\n";
+    }
+    const std::size_t fileLookups = 20;
+    std::size_t found = 0;
+    double fileNs = nanosPerItem(fileLookups, [&] {
+        for (std::size_t i = 0; i < fileLookups; ++i) {
+            std::ifstream in(file);
+            std::string line, wanted = "Electronic," + names[(i * 7919) % items] + ",";
+            while (std::getline(in, line)) {
+                if (line.compare(0, wanted.size(), wanted) == 0) {
+                    ++found;
+                    break;
+                }
+            }
+        }
+    });
+    std::cout << "  saved file:  " << fileNs << " ns/lookup (" << found << " found)\n";
+    std::remove(file.c_str());
+}
+
+// Function to print stock from the shared table of the running inventory process: the named
+// items, or every item if no names are given
+int runStockReader(const std::vector<std::string>& names) {
+    try {
+        SharedStockReader reader;
+        auto print = [](const SharedItem& item) {
+            std::cout << item.name << ": " << item.quantity << " in stock (" << item.type << ", " << item.price << ")\n";
+        };
+        if (names.empty()) reader.forEach(print);
+        for (const auto& name : names) {
+            SharedItem item;
+            if (reader.lookup(name, item)) print(item);
+            else std::cout << name << ": not found\n";
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cout << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
+
+// Function to run a local change-data-capture consumer: follows the change log like tail -f and
+// prints every event from the given sequence on; restart it with the last printed sequence + 1 to resume
+int runChangeConsumer(const std::string& path, std::uint64_t from) {
+    std::cout << "Following " << path << " from sequence " << from << " (Ctrl+C to stop)\n";
+    std::streamoff offset = 0;
+    for (;;) {
+        offset = ChangeEvent::readLog(path, from, offset, [](const ChangeEvent& event) {
+            std::cout << event.toLine() << "\n";
+        });
+        std::cout.flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+}
+
+// Workload capture and replay. A capture records every line of menu input with the time it
+// arrived, and the start and end of every main-menu operation, in a compact binary trace: the
+// magic "IMSTRACE", a format version byte, then records made of a kind byte, the microseconds
+// since the previous record as a varint and a payload (input, checkpoint and snapshot: length
+// varint and text; operation start or end: the menu choice as a varint). The trace starts with the
+// state the session started from: every record a recovery from the checkpoint would restore, and
+// the saved inventory file if there is one. A replay restores that state in a scratch directory
+// and feeds the recorded input back through std::cin, so exactly the same code runs, as fast as
+// possible or at the original pacing.
+struct TraceRecord {
+    enum Kind : std::uint8_t { Input = 1, Begin = 2, End = 3, Checkpoint = 4, Snapshot = 5 };
+    static constexpr char MAGIC[9] = "IMSTRACE";
+    static constexpr std::uint8_t VERSION = 2;
+
+    Kind kind = Input;
+    std::uint64_t micros = 0; // Since the start of the capture
+    int operation = 0;        // Begin and End: the main-menu choice
+    std::string text;         // Input: one line, with its newline if it had one; Checkpoint: one item
+                              // record; Snapshot: the whole saved inventory file
+
+    // Function to read a whole trace; throws if the file is not a trace. A record cut short
+    // (the capture was killed while writing it) ends the trace.
+    static std::vector<TraceRecord> readAll(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::ios_base::failure("Error opening trace " + path + ".");
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (data.size() < sizeof(MAGIC) || data.compare(0, sizeof(MAGIC) - 1, MAGIC) != 0 ||
+            static_cast<std::uint8_t>(data[sizeof(MAGIC) - 1]) != VERSION)
+            throw std::invalid_argument(path + " is not a version " + std::to_string(VERSION) + " trace.");
+        std::size_t at = sizeof(MAGIC);
+        auto varint = [&](std::uint64_t& value) {
+            value = 0;
+            for (int shift = 0; at < data.size() && shift < 64; shift += 7) {
+                std::uint8_t byte = static_cast<std::uint8_t>(data[at++]);
+                value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) return true;
+            }
+            return false;
+        };
+        std::vector<TraceRecord> records;
+        std::uint64_t clock = 0;
+        while (at < data.size()) {
+            TraceRecord record;
+            record.kind = static_cast<Kind>(data[at++]);
+            std::uint64_t delta = 0, payload = 0;
+            if (!varint(delta) || !varint(payload)) break;
+            record.micros = clock += delta;
+            if (record.kind == Input || record.kind == Checkpoint || record.kind == Snapshot) {
+                if (payload > data.size() - at) break;
+                record.text = data.substr(at, payload);
+                at += payload;
+            } else if (record.kind == Begin || record.kind == End) {
+                record.operation = static_cast<int>(payload);
+            } else {
+                throw std::invalid_argument("Unknown record in trace " + path + ".");
+            }
+            records.push_back(std::move(record));
+        }
+        return records;
+    }
+};
+
+// Writer of a trace; records are buffered and flushed at the end of every operation, so a
+// capture that is killed loses at most the operation in progress
+class TraceWriter {
+    std::ofstream out;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::uint64_t last = 0; // Microseconds of the previous record
+    std::string buffer;
+
+    void varint(std::uint64_t value) {
+        for (; value >= 0x80; value >>= 7) buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        buffer.push_back(static_cast<char>(value));
+    }
+
+    void header(TraceRecord::Kind kind, std::uint64_t payload) {
+        std::uint64_t now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        buffer.push_back(static_cast<char>(kind));
+        varint(now - last);
+        varint(payload);
+        last = now;
+    }
+
+public:
+    explicit TraceWriter(const std::string& path) : out(path, std::ios::binary | std::ios::trunc) {
+        if (!out) throw std::ios_base::failure("Error creating trace " + path + ".");
+        buffer.assign(TraceRecord::MAGIC, sizeof(TraceRecord::MAGIC) - 1);
+        buffer.push_back(static_cast<char>(TraceRecord::VERSION));
+    }
+
+    ~TraceWriter() { flush(); }
+
+    // Function to record a line of input
+    void input(const std::string& line) { text(TraceRecord::Input, line); }
+
+    // Function to record a text payload: a line of input or part of the starting state
+    void text(TraceRecord::Kind kind, const std::string& payload) {
+        header(kind, payload.size());
+        buffer += payload;
+    }
+
+    // Function to record the start or end of a main-menu operation
+    void operation(TraceRecord::Kind kind, int choice) {
+        header(kind, static_cast<std::uint64_t>(std::max(choice, 0)));
+        if (kind == TraceRecord::End) flush();
+    }
+
+    void flush() {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        out.flush();
+        buffer.clear();
+    }
+};
+
+// Input buffer for a capture: hands std::cin one line at a time from the real input and records
+// each line as it arrives
+class CaptureBuf : public std::streambuf {
+    std::streambuf* source;
+    TraceWriter& trace;
+    std::string line;
+
+protected:
+    int_type underflow() override {
+        line.clear();
+        for (int_type c = source->sbumpc(); c != traits_type::eof(); c = source->sbumpc()) {
+            line.push_back(traits_type::to_char_type(c));
+            if (c == '\n') break;
+        }
+        if (line.empty()) return traits_type::eof();
+        trace.input(line);
+        setg(line.data(), line.data(), line.data() + line.size());
+        return traits_type::to_int_type(line[0]);
+    }
+
+public:
+    CaptureBuf(std::streambuf* input, TraceWriter& writer) : source(input), trace(writer) {}
+};
+
+// Thrown through std::cin when a replay runs out of input. It is not a std::exception on purpose:
+// the menu functions catch those and carry on, and this must end the session instead.
+struct TraceEnded {};
+
+// Input buffer for a replay: hands std::cin the recorded lines, at their original times if paced
+class ReplayBuf : public std::streambuf {
+    const std::vector<TraceRecord>& records;
+    std::size_t next = 0;
+    bool paced;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string line;
+
+protected:
+    int_type underflow() override {
+        while (next < records.size() && records[next].kind != TraceRecord::Input) ++next;
+        if (next == records.size()) throw TraceEnded();
+        const TraceRecord& record = records[next++];
+        if (paced) std::this_thread::sleep_until(start + std::chrono::microseconds(record.micros));
+        line = record.text;
+        setg(line.data(), line.data(), line.data() + line.size());
+        return traits_type::to_int_type(line[0]);
+    }
+
+public:
+    ReplayBuf(const std::vector<TraceRecord>& trace, bool pacedReplay) : records(trace), paced(pacedReplay) {}
+};
+
+// Phase markers of a replay. They do nothing, but they are never inlined, so a profiler can hook
+// them, e.g. "perf probe -x ims_advanced_cpp imsPhaseBegin operation" and the same for imsPhaseEnd.
+extern "C" __attribute__((noinline)) void imsPhaseBegin(int operation) { asm volatile("" : : "r"(operation) : "memory"); }
+extern "C" __attribute__((noinline)) void imsPhaseEnd(int operation) { asm volatile("" : : "r"(operation) : "memory"); }
+
+// A menu session that is captured to a trace or replayed from one. While it exists, std::cin reads
+// through the session. With markers, a replay calls the phase markers around every operation and,
+// if IMS_PERF_CTL names the control FIFO of "perf record --control fifo:<path>", enables perf only
+// during operations (start perf with -D -1 so it waits).
+class MenuSession {
+    std::unique_ptr<TraceWriter> writer;
+    std::vector<TraceRecord> records;
+    std::unique_ptr<std::streambuf> input;
+    std::streambuf* original = nullptr;
+    std::string tracePath;
+    bool markers = false;
+    int perfControl = -1;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now(), operationStart;
+    std::map<int, std::vector<double>> replayed; // Per menu choice: microseconds of each replayed operation
+    std::string scratch;                         // Replay: directory holding the files the replay writes
+
+    void perf(const char* command) {
+        if (perfControl >= 0 && ::write(perfControl, command, std::strlen(command)) < 0) {
+            ::close(perfControl);
+            perfControl = -1;
+        }
+    }
+
+    MenuSession() = default;
+
+public:
+    MenuSession(const MenuSession&) = delete;
+    MenuSession& operator=(const MenuSession&) = delete;
+
+    // Function to start capturing the session to path. The starting state goes first: the records
+    // a recovery from the checkpoint would restore, and the contents of the saved inventory file.
+    static std::unique_ptr<MenuSession> record(const std::string& path, const std::vector<std::string>& checkpoint,
+                                               const std::string& snapshotPath) {
+        std::unique_ptr<MenuSession> session(new MenuSession());
+        session->tracePath = path;
+        session->writer = std::make_unique<TraceWriter>(path);
+        for (const auto& record : checkpoint) session->writer->text(TraceRecord::Checkpoint, record);
+        std::ifstream snapshot(snapshotPath, std::ios::binary);
+        if (snapshot) {
+            std::string contents((std::istreambuf_iterator<char>(snapshot)), std::istreambuf_iterator<char>());
+            session->writer->text(TraceRecord::Snapshot, contents);
+        }
+        session->writer->flush();
+        session->input = std::make_unique<CaptureBuf>(std::cin.rdbuf(), *session->writer);
+        session->original = std::cin.rdbuf(session->input.get());
+        return session;
+    }
+
+    // Function to replay the session captured in path. The starting state is restored in a new
+    // scratch directory as the files named by scratchFile(), so a replay never reads or writes the
+    // live checkpoint, logs or saved file.
+    static std::unique_ptr<MenuSession> replay(const std::string& path, bool paced, bool markers) {
+        std::unique_ptr<MenuSession> session(new MenuSession());
+        session->tracePath = path;
+        session->records = TraceRecord::readAll(path);
+        session->markers = markers;
+        const char* tmp = std::getenv("TMPDIR");
+        std::string dir = std::string(tmp ? tmp : "/tmp") + "/ims_replay_XXXXXX";
+        if (!::mkdtemp(dir.data())) throw std::system_error(errno, std::generic_category(), dir);
+        session->scratch = dir;
+        std::vector<std::string> checkpoint;
+        for (const auto& record : session->records) {
+            if (record.kind == TraceRecord::Checkpoint) checkpoint.push_back(record.text);
+            if (record.kind != TraceRecord::Snapshot) continue;
+            std::ofstream snapshot(session->scratchFile("inventory.txt"), std::ios::binary);
+            snapshot << record.text;
+            if (!snapshot) throw std::ios_base::failure("Error restoring the saved inventory file.");
+        }
+        Checkpointer::writeCheckpoint(session->scratchFile("inventory.ckpt"), checkpoint);
+        const char* control = std::getenv("IMS_PERF_CTL");
+        if (markers && control) {
+            session->perfControl = ::open(control, O_WRONLY | O_CLOEXEC);
+            if (session->perfControl < 0) throw std::system_error(errno, std::generic_category(), control);
+        }
+        session->input = std::make_unique<ReplayBuf>(session->records, paced);
+        session->original = std::cin.rdbuf(session->input.get());
+        std::cin.exceptions(std::ios::badbit); // Lets TraceEnded out of the stream
+        return session;
+    }
+
+    ~MenuSession() {
+        std::cin.exceptions(std::ios::goodbit);
+        std::cin.clear();
+        if (original) std::cin.rdbuf(original);
+        if (perfControl >= 0) ::close(perfControl);
+        std::error_code ignored;
+        if (!scratch.empty()) std::filesystem::remove_all(scratch, ignored);
+    }
+
+    // Function to get the path of a file in the replay's scratch directory
+    std::string scratchFile(const std::string& name) const { return scratch + "/" + name; }
+
+    // Functions called by the menu around every operation
+    void begin(int choice) {
+        if (writer) writer->operation(TraceRecord::Begin, choice);
+        if (!markers) {
+            operationStart = std::chrono::steady_clock::now();
+            return;
+        }
+        perf("enable\n");
+        imsPhaseBegin(choice);
+        operationStart = std::chrono::steady_clock::now();
+    }
+
+    void end(int choice) {
+        auto now = std::chrono::steady_clock::now();
+        if (writer) {
+            writer->operation(TraceRecord::End, choice);
+            return;
+        }
+        replayed[choice].push_back(std::chrono::duration<double, std::micro>(now - operationStart).count());
+        if (markers) {
+            imsPhaseEnd(choice);
+            perf("disable\n");
+        }
+    }
+
+    // Function to report on the session once it is over; names holds the menu's operations
+    void finish(std::ostream& out, const std::vector<std::string>& names) const {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        if (writer) {
+            out << "Session captured to " << tracePath << ".\n";
+            return;
+        }
+        std::size_t operations = 0;
+        for (const auto& entry : replayed) operations += entry.second.size();
+        double recorded = records.empty() ? 0.0 : records.back().micros / 1e6;
+        out << "Replayed " << operations << " operations from " << tracePath << " in " << seconds
+            << " s (captured session: " << recorded << " s)\n";
+        char row[128];
+        std::snprintf(row, sizeof(row), "%-26s %7s %11s %11s %11s\n", "operation", "count", "total ms", "mean us", "max us");
+        out << row;
+        for (const auto& entry : replayed) {
+            double total = 0, longest = 0;
+            for (double micros : entry.second) {
+                total += micros;
+                longest = std::max(longest, micros);
+            }
+            std::string name = entry.first >= 1 && static_cast<std::size_t>(entry.first) <= names.size()
+                                   ? names[entry.first - 1] : "choice " + std::to_string(entry.first);
+            std::snprintf(row, sizeof(row), "%-26s %7zu %11.2f %11.1f %11.1f\n", name.c_str(), entry.second.size(),
+                          total / 1000, total / entry.second.size(), longest);
+            out << row;
+        }
+    }
+};
+
+// Function to run a benchmark by name; returns the process exit code
+int runBenchmark(const std::string& name, std::size_t items) {
+    if (name == "scan") benchmarkScan(items);
+    else if (name == "batch") benchmarkBatch(items);
+    else if (name == "cdc") benchmarkChangeFeed(items);
+    else if (name == "cold") benchmarkColdTier(items);
+    else if (name == "money") benchmarkMoneyKernels(items);
+    else if (name == "asyncsave") benchmarkAsyncSave(items);
+    else if (name == "shm") benchmarkSharedStock(items);
+    else if (name == "report") benchmarkReport(items);
+    else if (name == "pick") benchmarkPickRoute(items);
+    else if (name == "parallel") benchmarkParallel(items);
+    else if (name == "pipeline") benchmarkPipeline(items);
+    else if (name == "reserve") benchmarkReservations(items);
+    else if (name == "alerts") benchmarkAlerts(items);
+    else if (name == "reconcile") benchmarkReconcile(items);
+    else {
+        std::cerr << "Unknown benchmark: " << name << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Helper function to parse a count given on the command line
+std::uint64_t parseCount(const std::string& text) {
+    std::uint64_t count = 0;
+    auto parsed = std::from_chars(text.data(), text.data() + text.size(), count);
+    if (text.empty() || parsed.ec != std::errc() || parsed.ptr != text.data() + text.size())
+        throw std::invalid_argument("Invalid count: " + text);
+    return count;
+}
+
+// Main function where the program starts
+int main(int argc, char* argv[]) {
+    std::unique_ptr<MenuSession> session;
+    std::unique_ptr<InventoryManager> inventoryManager;
+    try {
+        if (argc > 2 && std::string(argv[1]) == "--bench")
+            return runBenchmark(argv[2], argc > 3 ? parseCount(argv[3]) : 1000000);
+        if (argc > 1 && std::string(argv[1]) == "--cdc-consumer")
+            return runChangeConsumer("changes.log", argc > 2 ? parseCount(argv[2]) : 1);
+        if (argc > 1 && std::string(argv[1]) == "--stock")
+            return runStockReader(std::vector<std::string>(argv + 2, argv + argc));
+
+        // Capture the session to a trace, or replay one: --record <trace>, --replay <trace> [paced] [markers]
+        if (argc > 2 && std::string(argv[1]) == "--record") {
+            inventoryManager = std::make_unique<InventoryManager>();
+            session = MenuSession::record(argv[2], inventoryManager->checkpointRecords(), "inventory.txt");
+        } else if (argc > 2 && std::string(argv[1]) == "--replay") {
+            std::vector<std::string> options(argv + 3, argv + argc);
+            auto has = [&](const char* option) { return std::find(options.begin(), options.end(), option) != options.end(); };
+            session = MenuSession::replay(argv[2], has("paced"), has("markers"));
+            // Start from the captured state in the scratch directory, without sharing stock
+            inventoryManager = std::make_unique<InventoryManager>(
+                session->scratchFile("inventory.ckpt"), session->scratchFile("inventory.log"),
+                session->scratchFile("changes.log"), "");
+            inventoryManager->setSnapshotFile(session->scratchFile("inventory.txt"));
+            inventoryManager->setShipmentLog(session->scratchFile("shipments.log"));
+        } else {
+            inventoryManager = std::make_unique<InventoryManager>();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    const std::vector<std::string> operations = {"Add Item", "Remove Item", "Display Inventory", "Save to File",
+                                                  "Load from File", "Manage Orders", "Recover from Checkpoint",
+                                                  "Receive Shipment", "Export Report", "Put Away Stock", "Bulk Operations",
+                                                  "Reservations", "Alerts", "Exit"};
+    InventoryManager& manager = *inventoryManager;
+    int choice = 0;
+
+    try {
+        do {
+            std::cout << "\nInventory Management System\n";
+            for (std::size_t i = 0; i < operations.size(); ++i) std::cout << i + 1 << ". " << operations[i] << "\n";
+            choice = manager.getIntInput("Choose an option: ");
+            if (session) session->begin(choice);
+
+            switch (choice) {
+                case 1: manager.addItem(); break;
+                case 2: manager.removeItem(); break;
+                case 3: manager.displayInventory(); break;
+                case 4: manager.saveToFile(); break;
+                case 5: manager.loadFromFile(); break;
+                case 6: manager.manageOrders(); break;
+                case 7: manager.recoverFromCheckpoint(); break;
+                case 8: manager.receiveShipment(); break;
+                case 9: manager.exportReport(); break;
+                case 10: manager.putAwayStock(); break;
+                case 11: manager.bulkOperations(); break;
+                case 12: manager.manageReservations(); break;
+                case 13: manager.manageAlerts(); break;
+                case 14: std::cout << "Exiting program.\n"; break;
+                default: std::cout << "Invalid choice.\n"; break;
+            }
+            manager.maintain();
+            if (session) session->end(choice);
+        } while (choice != 14);
+    } catch (const TraceEnded&) {
+        std::cerr << "The trace ended before the session did.\n";
+    }
+    if (session) session->finish(std::cerr, operations);
 
     return 0;
 }